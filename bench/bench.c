@@ -0,0 +1,531 @@
+/**
+ * @file bench.c
+ * @author Arjun Pathak
+ * @brief Benchmarks for the search structures in this project.
+ *
+ * The program expects the path to a newline terminated word file, followed by optional counts of
+ * the queries to run and the results to request per query. Queries are sampled from the words of
+ * the dictionary itself with a fixed seed, so that runs on the same file are comparable. For every
+ * structure the build time, the memory held and the average latency per query are printed.
+ */
+
+#define DEFAULT_QUERIES 100000
+#define DEFAULT_RESULTS 5
+#define MAX_QUERY_LENGTH 8
+#define DEFAULT_CACHE_BYTES (16 << 20)
+#define SHARDS_COUNT 4
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cache.h"
+#include "engine.h"
+#include "pool.h"
+#include "shards.h"
+#include "suffix.h"
+#include "trie.h"
+
+/**
+ * @brief Returns the current value of the monotonic clock in nanoseconds.
+ */
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief Reads all the lines of the file into an array of words.
+ *
+ * @param[in] path The path to the word file.
+ * @param[out] wordsCount The number of words that were read.
+ *
+ * @return The array of words, or NULL if the file could not be opened.
+ */
+
+static char **readWords(const char *path, int *wordsCount) {
+    FILE *data = fopen(path, "r");
+    if (data == NULL) {
+        return NULL;
+    }
+    int capacity = 1024;
+    char **words = malloc(sizeof(char *) * capacity);
+    char *line = NULL;
+    size_t length = 0;
+    ssize_t read;
+
+    *wordsCount = 0;
+    while ((read = getline(&line, &length, data)) != -1) {
+        if (*wordsCount == capacity) {
+            capacity *= 2;
+            words = realloc(words, sizeof(char *) * capacity);
+        }
+        line[strcspn(line, "\r\n")] = '\0';
+        words[(*wordsCount)++] = strdup(line);
+    }
+    free(line);
+    fclose(data);
+    return words;
+}
+
+/**
+ * @brief Samples queries out of the dictionary.
+ *
+ * Prefix queries are the first one to three letters of a random word. Infix queries are two to
+ * four letters taken from a random position inside a random word.
+ *
+ * @param[in] words The dictionary words.
+ * @param[in] wordsCount The number of dictionary words.
+ * @param[in] queriesCount The number of queries to sample.
+ * @param[in] infix If true, infix queries are sampled, otherwise prefix queries.
+ *
+ * @return An array of queriesCount buffers of MAX_QUERY_LENGTH bytes each.
+ */
+
+static char (*sampleQueries(char **words, int wordsCount, int queriesCount, int infix))[MAX_QUERY_LENGTH] {
+    char (*queries)[MAX_QUERY_LENGTH] = calloc(queriesCount, MAX_QUERY_LENGTH);
+    srand(1);
+    for (int i = 0; i < queriesCount; i++) {
+        const char *word = words[rand() % wordsCount];
+        int wordLength = strlen(word);
+        int length = infix ? 2 + rand() % 3 : 1 + rand() % 3;
+        if (length > wordLength) {
+            length = wordLength;
+        }
+        int start = infix ? rand() % (wordLength - length + 1) : 0;
+        memcpy(queries[i], word + start, length);
+    }
+    return queries;
+}
+
+/**
+ * @brief Runs each query against the structure and returns the average latency in nanoseconds.
+ *
+ * @param[in] search The completion function under test, either a predictN() or a searchN() call.
+ * @param[in] structure The structure that is passed through to the search function.
+ * @param[in] queries The queries to be run.
+ * @param[in] queriesCount The number of queries.
+ * @param[in] results The number of results requested per query.
+ */
+
+static double timeQueries(char **(*search)(void *, string *, int), void *structure,
+                          char (*queries)[MAX_QUERY_LENGTH], int queriesCount, int results) {
+    double start = now();
+    for (int i = 0; i < queriesCount; i++) {
+        string *query = initString(queries[i], strlen(queries[i]));
+        char **buffer = search(structure, query, results);
+        for (int j = 0; j < results; j++) {
+            free(buffer[j]);
+        }
+        free(buffer);
+        delString(query);
+    }
+    return (now() - start) / queriesCount;
+}
+
+/**
+ * @brief Runs each query against the Trie, returning views into the pool, and returns the average
+ * latency in nanoseconds.
+ *
+ * @param[in] root The Trie.
+ * @param[in] pool The pool every word of the Trie is interned in.
+ * @param[in] queries The queries to be run.
+ * @param[in] queriesCount The number of queries.
+ * @param[in] results The number of results requested per query.
+ * @param[out] mismatches The number of queries whose results differ from predictN().
+ */
+
+static double timeViewQueries(Node *root, WordPool *pool, char (*queries)[MAX_QUERY_LENGTH],
+                              int queriesCount, int results, int *mismatches) {
+    WordView *views = malloc(sizeof(WordView) * results);
+    double start = now();
+    for (int i = 0; i < queriesCount; i++) {
+        string *query = initString(queries[i], strlen(queries[i]));
+        predictViews(root, pool, query, results, views);
+        delString(query);
+    }
+    double elapsed = (now() - start) / queriesCount;
+
+    *mismatches = 0;
+    for (int i = 0; i < queriesCount; i++) {
+        string *query = initString(queries[i], strlen(queries[i]));
+        string *copy = duplicate(query);
+        char **expected = predictN(root, query, results);
+        int found = predictViews(root, pool, copy, results, views);
+        int same = 1;
+        for (int j = 0; j < results; j++) {
+            if ((expected[j] == NULL) != (j >= found)
+                || (expected[j] && strcasecmp(expected[j], views[j].word) != 0)) {
+                same = 0;
+            }
+            free(expected[j]);
+        }
+        *mismatches += !same;
+        free(expected);
+        delString(query);
+        delString(copy);
+    }
+    free(views);
+    return elapsed;
+}
+
+/**
+ * @brief Runs all the queries as one batch against the Trie and returns the average latency.
+ *
+ * @param[in] root The Trie.
+ * @param[in] queries The queries to be run.
+ * @param[in] queriesCount The number of queries.
+ * @param[in] results The number of results requested per query.
+ * @param[out] mismatches The number of queries whose results differ from predictN().
+ */
+
+static double timeBatchedQueries(Node *root, char (*queries)[MAX_QUERY_LENGTH], int queriesCount,
+                                 int results, int *mismatches) {
+    string **words = malloc(sizeof(string *) * queriesCount);
+    char ***buffers = malloc(sizeof(char **) * queriesCount);
+    double start = now();
+    for (int i = 0; i < queriesCount; i++) {
+        words[i] = initString(queries[i], strlen(queries[i]));
+    }
+    predictNBatch(root, words, queriesCount, results, buffers);
+    for (int i = 0; i < queriesCount; i++) {
+        for (int j = 0; j < results; j++) {
+            free(buffers[i][j]);
+        }
+        free(buffers[i]);
+        delString(words[i]);
+    }
+    double elapsed = (now() - start) / queriesCount;
+
+    *mismatches = 0;
+    for (int i = 0; i < queriesCount; i++) {
+        words[i] = initString(queries[i], strlen(queries[i]));
+    }
+    predictNBatch(root, words, queriesCount, results, buffers);
+    for (int i = 0; i < queriesCount; i++) {
+        char **expected = predictN(root, words[i], results);
+        int same = 1;
+        for (int j = 0; j < results; j++) {
+            if ((expected[j] == NULL) != (buffers[i][j] == NULL)
+                || (expected[j] && strcmp(expected[j], buffers[i][j]) != 0)) {
+                same = 0;
+            }
+            free(expected[j]);
+            free(buffers[i][j]);
+        }
+        *mismatches += !same;
+        free(expected);
+        free(buffers[i]);
+        delString(words[i]);
+    }
+    free(words);
+    free(buffers);
+    return elapsed;
+}
+
+/**
+ * @brief Runs each query against the structure and the Trie, and counts differing result sets.
+ *
+ * @param[in] search The completion function under test.
+ * @param[in] structure The structure that is passed through to the search function.
+ * @param[in] root The reference Trie.
+ * @param[in] queries The queries to be run.
+ * @param[in] queriesCount The number of queries.
+ * @param[in] results The number of results requested per query.
+ */
+
+static int countMismatches(char **(*search)(void *, string *, int), void *structure, Node *root,
+                           char (*queries)[MAX_QUERY_LENGTH], int queriesCount, int results) {
+    int mismatches = 0;
+    for (int i = 0; i < queriesCount; i++) {
+        string *query = initString(queries[i], strlen(queries[i]));
+        char **expected = predictN(root, query, results);
+        char **buffer = search(structure, query, results);
+        int same = 1;
+        for (int j = 0; j < results; j++) {
+            if ((expected[j] == NULL) != (buffer[j] == NULL)
+                || (expected[j] && strcmp(expected[j], buffer[j]) != 0)) {
+                same = 0;
+            }
+            free(expected[j]);
+            free(buffer[j]);
+        }
+        mismatches += !same;
+        free(expected);
+        free(buffer);
+        delString(query);
+    }
+    return mismatches;
+}
+
+static char **trieSearch(void *root, string *query, int results) {
+    return predictN(root, query, results);
+}
+
+static char **deepeningSearch(void *root, string *query, int results) {
+    return predictDeepening(root, query, results);
+}
+
+static char **cachedSearch(void *structure, string *query, int results) {
+    void **pair = structure;
+    return cachedPredictN(pair[0], pair[1], query, results);
+}
+
+static char **engineSearch(void *engine, string *query, int results) {
+    return engineComplete(engine, query, results);
+}
+
+static char **shardsSearch(void *set, string *query, int results) {
+    return predictShards(set, NULL, 0, query, results);
+}
+
+/**
+ * @brief A helper function that splits the words round robin into shards, one word file each.
+ *
+ * @return The set of shards, or NULL if a word file could not be written.
+ */
+
+static ShardSet *loadShards(char **words, int wordsCount) {
+    ShardSet *set = initShardSet();
+    for (int s = 0; s < SHARDS_COUNT; s++) {
+        char path[] = "/tmp/rmm_bench_shard_XXXXXX", name[16];
+        snprintf(name, sizeof(name), "shard%d", s);
+        int descriptor = mkstemp(path);
+        FILE *file = descriptor == -1 ? NULL : fdopen(descriptor, "w");
+        if (file == NULL) {
+            if (descriptor != -1) {
+                close(descriptor);
+                remove(path);
+            }
+            delShardSet(set);
+            return NULL;
+        }
+        for (int i = s; i < wordsCount; i += SHARDS_COUNT) {
+            fprintf(file, "%s\n", words[i]);
+        }
+        fclose(file);
+        loadShard(set, name, path);
+        remove(path);
+    }
+    return set;
+}
+
+static char **suffixSearch(void *index, string *query, int results) {
+    return searchN(index, query, results);
+}
+
+/**
+ * @brief A helper function that counts the nodes of the Trie.
+ */
+
+static size_t countNodes(Node *node) {
+    size_t count = 1;
+    for (int i = 0; i < 26; i++) {
+        if (node->children[i]) {
+            count += countNodes(node->children[i]);
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief A helper function that measures how much the two completion searches hold per query.
+ *
+ * The BFS of predictN() is replayed over the Nodes below the query. The number of entries it
+ * queued by the time it has its words is the size of the frontier predictN() allocates, and one
+ * more than the depth of its last word is the number of frames the path of predictDeepening()
+ * holds at its deepest.
+ *
+ * @param[in] root The Trie.
+ * @param[in] query The query.
+ * @param[in] results The number of results requested.
+ * @param[out] entries Receives the number of entries of the BFS frontier.
+ * @param[out] frames Receives the number of frames of the iterative deepening path.
+ */
+
+static void measureFrontier(Node *root, char *query, int results, size_t *entries,
+                            int *frames) {
+    string *word = initString(query, strlen(query));
+    sanitize(word);
+    Node *start = root;
+    for (int i = 0; i < word->length && start->children[word->array[i] - 'a']; i++) {
+        start = start->children[word->array[i] - 'a'];
+    }
+    delString(word);
+
+    size_t length = 0, capacity = 64;
+    Node **nodes = malloc(sizeof(Node *) * capacity);
+    int *depths = malloc(sizeof(int) * capacity);
+    nodes[length] = start;
+    depths[length++] = 0;
+    int found = 0;
+    *frames = 1;
+    for (size_t head = 0; head < length && found < results; head++) {
+        if (nodes[head]->isEndOfWord) {
+            found++;
+            *frames = depths[head] + 1;
+            if (found == results) {
+                break;
+            }
+        }
+        for (int i = 0; i < 26; i++) {
+            if (nodes[head]->children[i] == NULL) {
+                continue;
+            }
+            if (length == capacity) {
+                capacity *= 2;
+                nodes = realloc(nodes, sizeof(Node *) * capacity);
+                depths = realloc(depths, sizeof(int) * capacity);
+            }
+            nodes[length] = nodes[head]->children[i];
+            depths[length++] = depths[head] + 1;
+        }
+    }
+    *entries = length;
+    free(nodes);
+    free(depths);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        printf("Usage: %s dictionary.txt [queries] [results]\n", argv[0]);
+        return -1;
+    }
+    int queriesCount = argc > 2 ? atoi(argv[2]) : DEFAULT_QUERIES;
+    int results = argc > 3 ? atoi(argv[3]) : DEFAULT_RESULTS;
+    if (queriesCount <= 0 || results <= 0) {
+        printf("Invalid input for the number of queries or results.\n");
+        return -1;
+    }
+
+    int wordsCount;
+    char **words = readWords(argv[1], &wordsCount);
+    if (words == NULL || wordsCount == 0) {
+        printf("Error reading words from %s\n", argv[1]);
+        return -1;
+    }
+    printf("%d words, %d queries, %d results per query\n\n", wordsCount, queriesCount, results);
+
+    char (*prefixQueries)[MAX_QUERY_LENGTH] = sampleQueries(words, wordsCount, queriesCount, 0);
+    char (*infixQueries)[MAX_QUERY_LENGTH] = sampleQueries(words, wordsCount, queriesCount, 1);
+
+    double start = now();
+    Node *root = initTrie();
+    for (int i = 0; i < wordsCount; i++) {
+        insert(root, words[i]);
+    }
+    printf("%-24s build %8.1f ms  memory %12zu bytes\n", "trie", (now() - start) / 1e6,
+           countNodes(root) * sizeof(Node));
+
+    start = now();
+    WordPool *pool = initWordPool();
+    internTrie(pool, root);
+    printf("%-24s build %8.1f ms  memory %12zu bytes\n", "word pool", (now() - start) / 1e6,
+           poolMemory(pool));
+
+    start = now();
+    SuffixIndex *index = initSuffixIndex(root);
+    printf("%-24s build %8.1f ms  memory %12zu bytes\n", "suffix index", (now() - start) / 1e6,
+           suffixIndexMemory(index));
+
+    int enginesCount = 0;
+    while (engineTypes[enginesCount]) {
+        enginesCount++;
+    }
+    Engine **engines = calloc(enginesCount, sizeof(Engine *));
+    for (int e = 0; e < enginesCount; e++) {
+        if (engineTypes[e] == &trieEngine) {
+            continue;
+        }
+        Node *copy = initTrie();
+        for (int i = 0; i < wordsCount; i++) {
+            insert(copy, words[i]);
+        }
+        start = now();
+        engines[e] = initEngine(engineTypes[e], copy);
+        size_t bytes = engineMemory(engines[e]);
+        printf("%-24s build %8.1f ms  memory %12zu bytes  (%.1f bits per word)\n",
+               engineTypes[e]->name, (now() - start) / 1e6, bytes,
+               bytes * 8.0 / engineCount(engines[e]));
+    }
+    printf("\n");
+
+    printf("%-24s %10.0f ns/query\n", "trie prefix",
+           timeQueries(trieSearch, root, prefixQueries, queriesCount, results));
+    printf("%-24s %10.0f ns/query  (%d mismatches)\n", "trie prefix deepening",
+           timeQueries(deepeningSearch, root, prefixQueries, queriesCount, results),
+           countMismatches(deepeningSearch, root, root, prefixQueries, queriesCount, results));
+    size_t entriesTotal = 0, entriesMax = 0;
+    long framesTotal = 0;
+    int framesMax = 0;
+    for (int i = 0; i < queriesCount; i++) {
+        size_t entries;
+        int frames;
+        measureFrontier(root, prefixQueries[i], results, &entries, &frames);
+        entriesTotal += entries;
+        entriesMax = entries > entriesMax ? entries : entriesMax;
+        framesTotal += frames;
+        framesMax = frames > framesMax ? frames : framesMax;
+    }
+    printf("%-24s %10.1f entries/query  (at most %zu)\n", "trie prefix frontier",
+           (double)entriesTotal / queriesCount, entriesMax);
+    printf("%-24s %10.1f frames/query   (at most %d)\n", "trie deepening path",
+           (double)framesTotal / queriesCount, framesMax);
+    int mismatches;
+    double viewed = timeViewQueries(root, pool, prefixQueries, queriesCount, results, &mismatches);
+    printf("%-24s %10.0f ns/query  (%d mismatches)\n", "trie prefix views", viewed, mismatches);
+    double batched = timeBatchedQueries(root, prefixQueries, queriesCount, results, &mismatches);
+    printf("%-24s %10.0f ns/query  (%d mismatches)\n", "trie batched prefix", batched,
+           mismatches);
+    ResultCache *cache = initResultCache(DEFAULT_CACHE_BYTES);
+    void *cached[2] = {cache, root};
+    printf("%-24s %10.0f ns/query  (%d mismatches)\n", "cached trie prefix",
+           timeQueries(cachedSearch, cached, prefixQueries, queriesCount, results),
+           countMismatches(cachedSearch, cached, root, prefixQueries, queriesCount, results));
+    printCacheStats(cache);
+    delResultCache(cache);
+    printf("%-24s %10.0f ns/query\n", "suffix index infix",
+           timeQueries(suffixSearch, index, infixQueries, queriesCount, results));
+    printf("%-24s %10.0f ns/query\n", "suffix index prefix",
+           timeQueries(suffixSearch, index, prefixQueries, queriesCount, results));
+    for (int e = 0; e < enginesCount; e++) {
+        if (engines[e] == NULL) {
+            continue;
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "%s prefix", engineTypes[e]->name);
+        printf("%-24s %10.0f ns/query  (%d mismatches)\n", name,
+               timeQueries(engineSearch, engines[e], prefixQueries, queriesCount, results),
+               countMismatches(engineSearch, engines[e], root, prefixQueries, queriesCount,
+                               results));
+        delEngine(engines[e]);
+    }
+    free(engines);
+
+    ShardSet *shards = loadShards(words, wordsCount);
+    if (shards) {
+        char name[32];
+        snprintf(name, sizeof(name), "%d shards prefix", SHARDS_COUNT);
+        printf("%-24s %10.0f ns/query  (%d mismatches)\n", name,
+               timeQueries(shardsSearch, shards, prefixQueries, queriesCount, results),
+               countMismatches(shardsSearch, shards, root, prefixQueries, queriesCount, results));
+        delShardSet(shards);
+    }
+
+    delSuffixIndex(index);
+    delWordPool(pool);
+    delTrie(root);
+    for (int i = 0; i < wordsCount; i++) {
+        free(words[i]);
+    }
+    free(words);
+    free(prefixQueries);
+    free(infixQueries);
+
+    return 0;
+}
@@ -0,0 +1,53 @@
+/**
+ * @file batch.h
+ * @author Arjun Pathak
+ * @brief Declaration of functions for the non-interactive batch mode
+ *
+ * This header declares the streaming batch mode, which answers newline separated queries from an
+ * input stream and writes one line of results per query, in the same order, to an output stream.
+ * On a machine with several cores, the queries are answered block by block on one thread per
+ * core while separate threads read and write, and the results still come out in input order. On
+ * a single core everything runs on the calling thread, since extra threads would only slow the
+ * queries down.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdio.h>
+
+#include "cache.h"
+#include "engine.h"
+
+/**
+ * @enum BatchFormat
+ * @brief The format of the result lines.
+ *
+ * BATCH_TSV writes the sanitized query followed by its results, all separated by tabs.
+ * BATCH_JSON writes one {"query": ..., "results": [...]} object per line.
+ */
+
+enum BatchFormat {
+    BATCH_TSV,
+    BATCH_JSON,
+};
+typedef enum BatchFormat BatchFormat;
+
+/**
+ * @brief Answers every query of the input stream and writes the results to the output stream.
+ *
+ * @param[in] engine The engine that answers the queries.
+ * @param[in] cache An optional result cache to answer the queries through, or NULL. The cache
+ * needs the pointer Trie of the engine.
+ * @param[in] resultsLength The number of results per query.
+ * @param[in] format The format of the result lines.
+ * @param[in] input The stream the queries are read from.
+ * @param[in] output The stream the results are written to.
+ *
+ * @return The number of queries that were answered, or -1 if the results could not be written.
+ */
+
+long runBatch(Engine *engine, ResultCache *cache, int resultsLength, BatchFormat format,
+              FILE *input, FILE *output);
+
+#endif
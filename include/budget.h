@@ -0,0 +1,101 @@
+/**
+ * @file budget.h
+ * @author Arjun Pathak
+ * @brief Declaration of functions for the memory budgeted Trie
+ *
+ * This header declares a byte budget for the Nodes of a Trie. Every Node that is created or freed
+ * through it is counted, so the bytes in use are known exactly at any time without walking the
+ * Trie. When an insert would take the Trie over its budget, the words with the lowest weight are
+ * evicted first, together with the Nodes that no remaining word needs, until the Trie is back
+ * under a low water mark below the budget. Evicting down to that mark instead of to the budget
+ * itself leaves room for the next inserts, so the Trie does not have to be walked on every insert
+ * once it is full.
+ */
+
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#include <stddef.h>
+
+#include "trie.h"
+
+/**
+ * @struct TrieBudget
+ * @brief This structure holds a Trie, its budget and the number of Nodes it is made of.
+ *
+ * @var TrieBudget::root
+ * Member root is the root of the Trie.
+ * @var TrieBudget::limit
+ * Member limit is the maximum number of bytes the Nodes of the Trie may hold.
+ * @var TrieBudget::nodesCount
+ * Member nodesCount is the number of Nodes of the Trie, including the root.
+ * @var TrieBudget::evictedCount
+ * Member evictedCount is the number of words evicted so far.
+ * @var TrieBudget::evictions
+ * Member evictions is the number of times the Trie had to be cut back to the low water mark.
+ */
+
+struct TrieBudget {
+    Node *root;
+    size_t limit;
+    size_t nodesCount;
+    size_t evictedCount;
+    size_t evictions;
+};
+typedef struct TrieBudget TrieBudget;
+
+/**
+ * @brief Puts a Trie under a budget, evicting words right away if it is already over it.
+ *
+ * @param[in] root The root of the Trie, which may already hold words. The budget does not take
+ * ownership of the Trie.
+ * @param[in] limit The maximum number of bytes the Nodes of the Trie may hold.
+ *
+ * @return The newly created budget.
+ */
+
+TrieBudget *initTrieBudget(Node *root, size_t limit);
+
+/**
+ * @brief Inserts a word into the Trie with a weight, evicting the lowest weight words first if
+ * the Nodes of the word would take the Trie over its budget.
+ *
+ * Words are evicted in the order of their weight, lowest first, and among words of the same
+ * weight the longest ones go first, since they hold the most Nodes and are the last ones the
+ * shortest-first completions would reach. The word being inserted is never evicted by its own
+ * insert, so its weight keeps adding up even when it is the lowest one.
+ *
+ * @param[in] budget The budget.
+ * @param[in] word The word to be inserted, the same way insertWeighted() takes it.
+ * @param[in] weight The weight to be added to the word.
+ *
+ * @return The number of words that were evicted, or -1 if the word does not fit in the budget
+ * even with every other word evicted, in which case it is not inserted.
+ */
+
+long budgetInsert(TrieBudget *budget, const char *word, unsigned int weight);
+
+/**
+ * @brief Returns the number of bytes held by the Nodes of the Trie. Allocator overhead is not
+ * counted.
+ *
+ * @param[in] budget The budget.
+ */
+
+size_t budgetMemory(TrieBudget *budget);
+
+/**
+ * @brief Reclaims the memory held by the budget. The Trie is not deleted.
+ *
+ * @param[in] budget The budget.
+ */
+
+void delTrieBudget(TrieBudget *budget);
+
+/**
+ * @brief A function to test the memory budgeted Trie and all supported operations on it.
+ */
+
+void testTrieBudget();
+
+#endif
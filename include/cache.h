@@ -0,0 +1,189 @@
+/**
+ * @file cache.h
+ * @author Arjun Pathak
+ * @brief Declaration of functions for the prefix result cache
+ *
+ * This header declares a bounded cache that sits in front of predictN(). Results are stored under
+ * the sanitized query and the number of results asked for, in a chained hash table, and all the
+ * entries are kept in a doubly linked list in least recently used order. When the bytes held by
+ * the entries go over the budget, entries are evicted from the cold end of the list. Words that are
+ * inserted through the cache drop every entry whose results they could change.
+ */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "cus_string.h"
+#include "trie.h"
+
+/**
+ * @struct CacheEntry
+ * @brief This structure holds the cached results of a single query.
+ *
+ * @var CacheEntry::query
+ * Member query is the sanitized query the results belong to.
+ * @var CacheEntry::matchedLength
+ * Member matchedLength is the length of the part of the query that was found in the Trie. The
+ * results are the words below that node, so only inserts that start with it can change them.
+ * @var CacheEntry::resultsLength
+ * Member resultsLength is the number of results that were asked for.
+ * @var CacheEntry::results
+ * Member results holds the cached words, unused entries are set to NULL.
+ * @var CacheEntry::bytes
+ * Member bytes is the number of heap bytes the entry is charged for.
+ * @var CacheEntry::queryNext
+ * Member queryNext chains the entry into its bucket of the query hash table.
+ * @var CacheEntry::matchedNext
+ * Member matchedNext chains the entry into its bucket of the matched prefix hash table.
+ * @var CacheEntry::prev
+ * Member prev points to the more recently used neighbour in the LRU list.
+ * @var CacheEntry::next
+ * Member next points to the less recently used neighbour in the LRU list.
+ */
+
+struct CacheEntry {
+    char *query;
+    int matchedLength;
+    int resultsLength;
+    char **results;
+    size_t bytes;
+    struct CacheEntry *queryNext;
+    struct CacheEntry *matchedNext;
+    struct CacheEntry *prev;
+    struct CacheEntry *next;
+};
+typedef struct CacheEntry CacheEntry;
+
+/**
+ * @struct ResultCache
+ * @brief This structure holds the hash tables, the LRU list and the statistics of the cache.
+ *
+ * @var ResultCache::byQuery
+ * Member byQuery is the hash table that lookups go through, keyed by query and results length.
+ * @var ResultCache::byMatched
+ * Member byMatched is the hash table that invalidation goes through, keyed by matched prefix.
+ * @var ResultCache::bucketsCount
+ * Member bucketsCount is the number of buckets in each of the two tables, a power of two.
+ * @var ResultCache::head
+ * Member head is the most recently used entry.
+ * @var ResultCache::tail
+ * Member tail is the least recently used entry, the next one to be evicted.
+ * @var ResultCache::budget
+ * Member budget is the maximum number of bytes the entries may hold.
+ * @var ResultCache::bytes
+ * Member bytes is the number of bytes the entries hold right now.
+ * @var ResultCache::entriesCount
+ * Member entriesCount is the number of cached queries.
+ * @var ResultCache::hits
+ * Member hits is the number of lookups that were answered from the cache.
+ * @var ResultCache::misses
+ * Member misses is the number of lookups that had to go to the Trie.
+ * @var ResultCache::evictions
+ * Member evictions is the number of entries dropped to stay within the budget.
+ * @var ResultCache::invalidations
+ * Member invalidations is the number of entries dropped because of an insert.
+ * @var ResultCache::ranked
+ * Member ranked is set if misses are answered by predictRanked() instead of predictN(). Inserting
+ * a word that is already in the Trie then raises its weight, which can reorder the results.
+ */
+
+struct ResultCache {
+    CacheEntry **byQuery;
+    CacheEntry **byMatched;
+    size_t bucketsCount;
+    CacheEntry *head;
+    CacheEntry *tail;
+    size_t budget;
+    size_t bytes;
+    size_t entriesCount;
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    size_t invalidations;
+    bool ranked;
+};
+typedef struct ResultCache ResultCache;
+
+/**
+ * @brief Creates an empty cache.
+ *
+ * @param[in] budget The maximum number of bytes the cached results may hold.
+ *
+ * @return The newly created cache.
+ */
+
+ResultCache *initResultCache(size_t budget);
+
+/**
+ * @brief Returns the first N matching words, from the cache if possible and from predictN() if not,
+ * or from predictRanked() if the cache is ranked.
+ *
+ * @param[in] cache The cache.
+ * @param[in] root The root of the Trie the cache belongs to.
+ * @param[in] word The word to be prefix matched. It is sanitized in place.
+ * @param[in] resultsLength The number of results to be returned.
+ *
+ * @return A buffer of resultsLength entries that the caller owns, just like with predictN().
+ */
+
+char **cachedPredictN(ResultCache *cache, Node *root, string *word, int resultsLength);
+
+/**
+ * @brief Inserts a word into the Trie and drops the cached results that it could change.
+ *
+ * @param[in] cache The cache.
+ * @param[in] root The root of the Trie the cache belongs to.
+ * @param[in] word The word to be inserted.
+ */
+
+void cachedInsert(ResultCache *cache, Node *root, const char *word);
+
+/**
+ * @brief Drops the cached results that inserting a word into the Trie could change, for callers
+ * that insert the word themselves.
+ *
+ * @param[in] cache The cache.
+ * @param[in] root The root of the Trie the cache belongs to.
+ * @param[in] word The word that is about to be inserted.
+ *
+ * @return false if the word is already in the Trie and the cache is not ranked, in which case
+ * nothing was dropped.
+ */
+
+bool invalidateWord(ResultCache *cache, Node *root, const char *word);
+
+/**
+ * @brief Drops every cached result, for changes to the Trie that can affect any query, like words
+ * being evicted from it.
+ *
+ * @param[in] cache The cache.
+ */
+
+void clearResultCache(ResultCache *cache);
+
+/**
+ * @brief Prints the hit, miss, eviction and invalidation counts of the cache.
+ *
+ * @param[in] cache The cache.
+ */
+
+void printCacheStats(ResultCache *cache);
+
+/**
+ * @brief Drops all the entries and deletes the cache.
+ *
+ * @param[in] cache The cache.
+ */
+
+void delResultCache(ResultCache *cache);
+
+/**
+ * @brief A function to test the cache and all supported operations on it.
+ */
+
+void testResultCache();
+
+#endif
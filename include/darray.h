@@ -0,0 +1,92 @@
+/**
+ * @file darray.h
+ * @author Arjun Pathak
+ * @brief Declaration of functions for the double-array Trie
+ *
+ * This header declares a Trie that keeps all of its transitions in two flat int arrays instead of
+ * a tree of pointer nodes. Every state s has a BASE value, and the transition from s on a letter
+ * with code c leads to the state t = BASE[s] + c if CHECK[t] == s. A lookup per letter is thus an
+ * addition and one comparison in two compact arrays. The structure is built once from a word list
+ * and answers the same queries as predictN(), with exactly the same results.
+ */
+
+#ifndef DARRAY_H
+#define DARRAY_H
+
+#include <stddef.h>
+
+#include "cus_string.h"
+
+/**
+ * @struct DoubleArray
+ * @brief This structure holds the BASE and CHECK arrays of the Trie.
+ *
+ * @var DoubleArray::base
+ * Member base holds the offset that the transitions out of every state are added to.
+ * @var DoubleArray::check
+ * Member check holds the parent of every state, or -1 if the slot is not used. The root is state
+ * 0 and is its own parent.
+ * @var DoubleArray::terminal
+ * Member terminal is set to 1 for the states that mark the end of a word.
+ * @var DoubleArray::size
+ * Member size is the number of slots in all three arrays.
+ * @var DoubleArray::statesCount
+ * Member statesCount is the number of slots that are in use.
+ */
+
+struct DoubleArray {
+    int *base;
+    int *check;
+    unsigned char *terminal;
+    int size;
+    int statesCount;
+};
+typedef struct DoubleArray DoubleArray;
+
+/**
+ * @brief Builds a double-array Trie out of a list of words.
+ *
+ * @param[in] words The words to be stored. Each word is lowercased and cut at its first character
+ * that is not a letter, the same way insert() does it.
+ * @param[in] wordsCount The number of words.
+ *
+ * @return The newly built Trie.
+ */
+
+DoubleArray *initDoubleArray(char **words, int wordsCount);
+
+/**
+ * @brief Returns the first N matching words, in the same order as predictN().
+ *
+ * @param[in] da The double-array Trie.
+ * @param[in] word The word to be prefix matched. It is sanitized in place.
+ * @param[in] resultsLength The number of results to be returned.
+ *
+ * @return A buffer of resultsLength entries, unused entries are set to NULL.
+ */
+
+char **daPredictN(DoubleArray *da, string *word, int resultsLength);
+
+/**
+ * @brief Returns the number of heap bytes that are held by the Trie.
+ *
+ * @param[in] da The double-array Trie.
+ */
+
+size_t doubleArrayMemory(DoubleArray *da);
+
+/**
+ * @brief Reclaims all the memory held by the Trie.
+ *
+ * @param[in] da The double-array Trie.
+ */
+
+void delDoubleArray(DoubleArray *da);
+
+/**
+ * @brief A function to test the double-array Trie against the pointer Trie.
+ */
+
+void testDoubleArray();
+
+#endif
@@ -0,0 +1,195 @@
+/**
+ * @file engine.h
+ * @author Arjun Pathak
+ * @brief Declaration of the pluggable completion engine interface
+ *
+ * This header declares a small table of function pointers that every search structure of the
+ * project can be driven through, so that the CLI and the benchmarks can swap one structure for
+ * another without knowing its layout. Every engine is built from a populated pointer Trie, which
+ * is the reference implementation and the only engine that can still take inserts afterwards. The
+ * static engines encode the Trie into their own form and then delete it.
+ */
+
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "cus_string.h"
+#include "trie.h"
+
+/**
+ * @struct EngineType
+ * @brief The name and the operations of one kind of engine.
+ *
+ * @var EngineType::name
+ * Member name is the name the engine is chosen by on the command line.
+ * @var EngineType::build
+ * Member build creates the structure of the engine out of a populated Trie, taking ownership of
+ * the Trie.
+ * @var EngineType::insert
+ * Member insert adds a word to the structure, or is NULL if the engine is read-only.
+ * @var EngineType::complete
+ * Member complete returns the same completions for a query as predictN() does on the Trie, or as
+ * predictRanked() does for the ranked engine.
+ * @var EngineType::completeBatch
+ * Member completeBatch answers many queries at once, or is NULL if the engine has no faster way
+ * to do that than answering them one by one.
+ * @var EngineType::count
+ * Member count returns the number of words held by the structure.
+ * @var EngineType::memory
+ * Member memory returns the number of heap bytes held by the structure.
+ * @var EngineType::destroy
+ * Member destroy reclaims all the memory held by the structure.
+ */
+
+struct EngineType {
+    const char *name;
+    void *(*build)(Node *root);
+    void (*insert)(void *structure, const char *word);
+    char **(*complete)(void *structure, string *word, int resultsLength);
+    void (*completeBatch)(void *structure, string **words, int wordsCount, int resultsLength,
+                          char ***results);
+    size_t (*count)(void *structure);
+    size_t (*memory)(void *structure);
+    void (*destroy)(void *structure);
+};
+typedef struct EngineType EngineType;
+
+/**
+ * @struct Engine
+ * @brief A built structure together with the operations that drive it.
+ *
+ * @var Engine::type
+ * Member type is the kind of the engine.
+ * @var Engine::structure
+ * Member structure is the search structure the operations are called on.
+ */
+
+struct Engine {
+    const EngineType *type;
+    void *structure;
+};
+typedef struct Engine Engine;
+
+/**
+ * @brief The reference engine, which answers queries straight from the pointer Trie.
+ */
+
+extern const EngineType trieEngine;
+
+/**
+ * @brief The engine that answers queries from the pointer Trie by weight, with predictRanked().
+ * It is not one of the engineTypes, which all return the completions of predictN(); the CLI
+ * switches from the reference engine to it when the words of the Trie have weights.
+ */
+
+extern const EngineType rankedEngine;
+
+/**
+ * @brief All the engines, the reference engine first, followed by a NULL entry.
+ */
+
+extern const EngineType *const engineTypes[];
+
+/**
+ * @brief Returns the engine type with the given name, or NULL if there is none.
+ *
+ * @param[in] name The name of the engine.
+ */
+
+const EngineType *findEngineType(const char *name);
+
+/**
+ * @brief Builds an engine out of a populated Trie.
+ *
+ * @param[in] type The kind of engine to build.
+ * @param[in] root The root of a populated Trie. The engine takes ownership of the Trie, the
+ * caller must not use it again unless engineTrie() hands it back.
+ *
+ * @return The newly built engine.
+ */
+
+Engine *initEngine(const EngineType *type, Node *root);
+
+/**
+ * @brief Adds a word to the engine.
+ *
+ * @param[in] engine The engine.
+ * @param[in] word The word to be inserted, lowercased and cut at its first character that is not
+ * a letter the same way insert() does it.
+ *
+ * @return false if the engine is read-only.
+ */
+
+bool engineInsert(Engine *engine, const char *word);
+
+/**
+ * @brief Returns the first N completions of a query, in the same order as predictN().
+ *
+ * @param[in] engine The engine.
+ * @param[in] word The query. It is sanitized in place.
+ * @param[in] resultsLength The number of results to be returned.
+ *
+ * @return A buffer of resultsLength entries, unused entries are set to NULL.
+ */
+
+char **engineComplete(Engine *engine, string *word, int resultsLength);
+
+/**
+ * @brief Returns the first N completions of many queries, the same ones engineComplete() returns.
+ *
+ * @param[in] engine The engine.
+ * @param[in] words The queries. Each one is sanitized in place.
+ * @param[in] wordsCount The number of queries.
+ * @param[in] resultsLength The number of results to be returned per query.
+ * @param[out] results Receives one buffer of resultsLength entries per query.
+ */
+
+void engineCompleteBatch(Engine *engine, string **words, int wordsCount, int resultsLength,
+                         char ***results);
+
+/**
+ * @brief Returns the number of words held by the engine.
+ *
+ * @param[in] engine The engine.
+ */
+
+size_t engineCount(Engine *engine);
+
+/**
+ * @brief Returns the number of heap bytes held by the engine.
+ *
+ * @param[in] engine The engine.
+ */
+
+size_t engineMemory(Engine *engine);
+
+/**
+ * @brief Returns the pointer Trie behind the engine, or NULL if the engine does not keep one.
+ *
+ * @param[in] engine The engine.
+ */
+
+Node *engineTrie(Engine *engine);
+
+/**
+ * @brief Reclaims all the memory held by the engine, including its Trie.
+ *
+ * @param[in] engine The engine.
+ */
+
+void delEngine(Engine *engine);
+
+/**
+ * @brief A differential test that checks every engine against predictN() on the pointer Trie.
+ *
+ * Every prefix of every word is queried, along with queries that only match part of the way, an
+ * uppercase query and the empty query, for a range of result counts. The same words are then
+ * answered as a single batch.
+ */
+
+void testEngines();
+
+#endif
@@ -0,0 +1,72 @@
+/**
+ * @file ingest.h
+ * @author Arjun Pathak
+ * @brief Declaration of functions for building the dictionary out of raw text
+ *
+ * This header declares the ingest mode, which turns raw text such as logs or documents into a
+ * dictionary with word frequencies in a single pass, instead of needing a clean file of one word
+ * per line. The text is read in large chunks that are tokenized and counted on several threads,
+ * each one into counts of its own, and the counts of all the threads are then added into the Trie
+ * as the weights of the words.
+ */
+
+#ifndef INGEST_H
+#define INGEST_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "budget.h"
+#include "trie.h"
+
+/**
+ * @struct IngestStats
+ * @brief What the ingest mode read and counted.
+ *
+ * @var IngestStats::bytes
+ * Member bytes is the number of bytes of text that were read.
+ * @var IngestStats::tokens
+ * Member tokens is the number of words that were counted.
+ * @var IngestStats::skipped
+ * Member skipped is the number of tokens that were not counted because they held digits,
+ * underscores, apostrophes or non-ASCII characters, or were longer than any real word.
+ * @var IngestStats::words
+ * Member words is the number of distinct words that were counted.
+ */
+
+struct IngestStats {
+    size_t bytes;
+    size_t tokens;
+    size_t skipped;
+    size_t words;
+};
+typedef struct IngestStats IngestStats;
+
+/**
+ * @brief Counts the words of a stream of raw text and adds the counts to the Trie as weights.
+ *
+ * A token is a run of letters, digits, underscores, apostrophes and non-ASCII bytes, so that
+ * identifiers, numbers, contractions and words of other scripts in the text are skipped as a
+ * whole instead of leaving stray letters behind. Apostrophes that quote a token are dropped
+ * first. Tokens made of letters only are lowercased and counted.
+ *
+ * @param[in] root The root of the Trie the words are added to.
+ * @param[in] budget The budget of the Trie, which the counts are added through so that the Trie
+ * never goes over it while the counts are merged, or NULL.
+ * @param[in] input The stream the text is read from.
+ * @param[in] threadsCount The number of threads that tokenize and count the text.
+ * @param[out] stats Receives what was read and counted.
+ *
+ * @return false if the stream could not be read.
+ */
+
+bool ingestText(Node *root, TrieBudget *budget, FILE *input, int threadsCount,
+                IngestStats *stats);
+
+/**
+ * @brief A function to test the ingest mode and all supported operations on it.
+ */
+
+void testIngest();
+
+#endif
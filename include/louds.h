@@ -0,0 +1,109 @@
+/**
+ * @file louds.h
+ * @author Arjun Pathak
+ * @brief Declaration of functions for the succinct (LOUDS encoded) static Trie
+ *
+ * This header declares a read-only encoding of a built Trie that uses a few bits per node instead
+ * of 26 pointers. The shape of the tree is stored as a level-order unary degree sequence (LOUDS):
+ * the nodes are numbered in BFS order and every node writes one 1 bit per child followed by a 0
+ * bit. Rank and select over that bit vector lead from a node to its children and back to its
+ * parent. The letter on the edge into every node is kept in a packed 5 bit label array, and a
+ * second bit vector marks the nodes that end a word.
+ */
+
+#ifndef LOUDS_H
+#define LOUDS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cus_string.h"
+#include "trie.h"
+
+/**
+ * @struct BitVector
+ * @brief A bit vector with a rank directory.
+ *
+ * @var BitVector::words
+ * Member words holds the bits, 64 to a word, lowest bit first.
+ * @var BitVector::ranks
+ * Member ranks holds the number of 1 bits that come before every block of 512 bits. It has one
+ * more entry than there are blocks, the last one being the total.
+ * @var BitVector::length
+ * Member length is the number of bits in the vector.
+ */
+
+struct BitVector {
+    uint64_t *words;
+    uint32_t *ranks;
+    size_t length;
+};
+typedef struct BitVector BitVector;
+
+/**
+ * @struct Louds
+ * @brief This structure holds the succinct encoding of a Trie.
+ *
+ * @var Louds::tree
+ * Member tree is the LOUDS bit vector describing the shape of the Trie.
+ * @var Louds::terminals
+ * Member terminals has the bit of a node set if the node marks the end of a word.
+ * @var Louds::labels
+ * Member labels holds the 5 bit letter index on the edge into every node.
+ * @var Louds::nodesCount
+ * Member nodesCount is the number of nodes in the Trie, including the root.
+ */
+
+struct Louds {
+    BitVector tree;
+    uint64_t *terminals;
+    uint64_t *labels;
+    size_t nodesCount;
+};
+typedef struct Louds Louds;
+
+/**
+ * @brief Encodes a built Trie into its succinct form. The Trie is left untouched.
+ *
+ * @param[in] root The root of a populated Trie.
+ *
+ * @return The newly built encoding.
+ */
+
+Louds *initLouds(Node *root);
+
+/**
+ * @brief Returns the first N matching words, in the same order as predictN().
+ *
+ * @param[in] louds The encoded Trie.
+ * @param[in] word The word to be prefix matched. It is sanitized in place.
+ * @param[in] resultsLength The number of results to be returned.
+ *
+ * @return A buffer of resultsLength entries, unused entries are set to NULL.
+ */
+
+char **loudsPredictN(Louds *louds, string *word, int resultsLength);
+
+/**
+ * @brief Returns the number of heap bytes that are held by the encoding.
+ *
+ * @param[in] louds The encoded Trie.
+ */
+
+size_t loudsMemory(Louds *louds);
+
+/**
+ * @brief Reclaims all the memory held by the encoding.
+ *
+ * @param[in] louds The encoded Trie.
+ */
+
+void delLouds(Louds *louds);
+
+/**
+ * @brief A function to test the LOUDS encoding against the pointer Trie.
+ */
+
+void testLouds();
+
+#endif
@@ -0,0 +1,149 @@
+/**
+ * @file ngram.h
+ * @author Arjun Pathak
+ * @brief Declaration of functions for the n-gram next word model
+ *
+ * This header declares a bigram and trigram model that suggests the next word after the last one
+ * or two words of a sentence. The words of the Trie make up the vocabulary, and a word is known by
+ * its id in the word pool, which is stored on its terminal Node, so the corpus is mapped to ids
+ * while it is being read, by walking the Trie one letter at a time. For every context the words
+ * that followed it are kept in one flat array, sorted by how often they followed it, so the top
+ * suggestions for a context are simply the first entries of its range.
+ */
+
+#ifndef NGRAM_H
+#define NGRAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "cus_string.h"
+#include "pool.h"
+#include "trie.h"
+
+/**
+ * @struct NGramTable
+ * @brief The words that followed each context, and how often, in compressed row form.
+ *
+ * @var NGramTable::contexts
+ * Member contexts holds the packed ids of every context that has at least one follower, sorted.
+ * @var NGramTable::starts
+ * Member starts holds, for every context, the position of its first follower. It has one more
+ * entry than there are contexts.
+ * @var NGramTable::next
+ * Member next holds the ids of the followers, each context's range sorted by descending count.
+ * @var NGramTable::counts
+ * Member counts holds how often each follower followed its context.
+ * @var NGramTable::contextsCount
+ * Member contextsCount is the number of contexts.
+ * @var NGramTable::entriesCount
+ * Member entriesCount is the number of distinct (context, follower) pairs that were kept.
+ */
+
+struct NGramTable {
+    uint64_t *contexts;
+    uint32_t *starts;
+    uint32_t *next;
+    uint32_t *counts;
+    size_t contextsCount;
+    size_t entriesCount;
+};
+typedef struct NGramTable NGramTable;
+
+/**
+ * @struct NGramModel
+ * @brief This structure holds the vocabulary and the bigram and trigram tables.
+ *
+ * @var NGramModel::root
+ * Member root is the Trie the vocabulary was taken from.
+ * @var NGramModel::pool
+ * Member pool holds the words of the vocabulary, indexed by id.
+ * @var NGramModel::vocabularyCount
+ * Member vocabularyCount is the number of words in the vocabulary, which are the words the pool
+ * held when the model was created.
+ * @var NGramModel::bigrams
+ * Member bigrams maps a single word to the words that followed it.
+ * @var NGramModel::trigrams
+ * Member trigrams maps a pair of words to the words that followed them.
+ * @var NGramModel::tokensCount
+ * Member tokensCount is the number of corpus tokens that were found in the vocabulary.
+ */
+
+struct NGramModel {
+    Node *root;
+    WordPool *pool;
+    int vocabularyCount;
+    NGramTable bigrams;
+    NGramTable trigrams;
+    size_t tokensCount;
+};
+typedef struct NGramModel NGramModel;
+
+/**
+ * @brief Creates a model with no n-grams yet, whose vocabulary is the words of the Trie.
+ *
+ * @param[in] root The root of a populated Trie.
+ * @param[in] pool The pool the words of the Trie are interned in. Words of the Trie that are not
+ * in the pool yet are interned. The model does not take ownership of the pool.
+ *
+ * @return The newly created model.
+ */
+
+NGramModel *initNGramModel(Node *root, WordPool *pool);
+
+/**
+ * @brief Counts the bigrams and trigrams of a corpus of plain text into the model.
+ *
+ * Trigrams that were seen only once are not kept.
+ *
+ * @param[in] model The model, which must not have been trained before.
+ * @param[in] corpus The stream the text is read from.
+ *
+ * @return The number of tokens of the corpus that were found in the vocabulary, or -1 if the
+ * temporary files the n-grams are counted in could not be written.
+ */
+
+long trainNGramModel(NGramModel *model, FILE *corpus);
+
+/**
+ * @brief Returns the N most likely next words after a context that start with a partial word, as
+ * views into the pool.
+ *
+ * @param[in] model The trained model.
+ * @param[in] context The words before the current one, oldest first.
+ * @param[in] contextCount The number of context words. Only the last two are used.
+ * @param[in] partial The part of the current word typed so far, which may be empty. It is
+ * sanitized in place.
+ * @param[in] resultsLength The number of results to be returned.
+ * @param[out] views Receives the results, it must have room for resultsLength views.
+ *
+ * @return The number of views that were filled in.
+ */
+
+int predictNext(NGramModel *model, char **context, int contextCount, string *partial,
+                int resultsLength, WordView *views);
+
+/**
+ * @brief Returns the number of heap bytes that are held by the model, not counting the pool.
+ *
+ * @param[in] model The model.
+ */
+
+size_t ngramMemory(NGramModel *model);
+
+/**
+ * @brief Reclaims all the memory held by the model. The Trie and the pool are not deleted.
+ *
+ * @param[in] model The model.
+ */
+
+void delNGramModel(NGramModel *model);
+
+/**
+ * @brief A function to test the n-gram model and all supported operations on it.
+ */
+
+void testNGramModel();
+
+#endif
@@ -0,0 +1,196 @@
+/**
+ * @file pool.h
+ * @author Arjun Pathak
+ * @brief Declaration of functions for the interned word pool
+ *
+ * This header declares a pool that stores every word of the dictionary exactly once, one after
+ * the other in fixed chunks of text, with the casing it had in the word file. Every word gets
+ * a small integer id, which is kept on the Trie Node the word ends at. Completions can then be
+ * returned as views into the pool, so answering a query allocates nothing per result. A chunk is
+ * never moved or freed before the pool is, so a view stays valid for as long as the pool lives,
+ * on any thread, even while more words are interned.
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "trie.h"
+
+#define POOL_CHUNK_SIZE 65536
+
+/**
+ * @struct WordPool
+ * @brief This structure holds the text of all the interned words and where each one starts.
+ *
+ * @var WordPool::chunks
+ * Member chunks holds the chunks of text, each word followed by a '\0'. A chunk is
+ * POOL_CHUNK_SIZE bytes, or just big enough for a single longer word.
+ * @var WordPool::chunksCount
+ * Member chunksCount is the number of chunks.
+ * @var WordPool::chunksCapacity
+ * Member chunksCapacity is the number of chunks the chunks array has room for.
+ * @var WordPool::chunkLength
+ * Member chunkLength is the number of bytes in use in the last chunk.
+ * @var WordPool::chunkCapacity
+ * Member chunkCapacity is the number of bytes the last chunk has room for.
+ * @var WordPool::textCapacity
+ * Member textCapacity is the number of bytes all the chunks have room for.
+ * @var WordPool::words
+ * Member words holds where in the chunks every word starts, indexed by id.
+ * @var WordPool::lengths
+ * Member lengths holds the number of characters of every word, indexed by id.
+ * @var WordPool::count
+ * Member count is the number of words in the pool.
+ * @var WordPool::capacity
+ * Member capacity is the number of words that words and lengths have room for.
+ */
+
+struct WordPool {
+    char **chunks;
+    int chunksCount;
+    int chunksCapacity;
+    size_t chunkLength;
+    size_t chunkCapacity;
+    size_t textCapacity;
+    const char **words;
+    uint32_t *lengths;
+    int count;
+    int capacity;
+};
+typedef struct WordPool WordPool;
+
+/**
+ * @struct WordView
+ * @brief A completion, pointing into the pool instead of owning a copy of the word.
+ *
+ * @var WordView::id
+ * Member id is the id of the word in the pool.
+ * @var WordView::word
+ * Member word points at the '\0' terminated word inside the pool.
+ * @var WordView::length
+ * Member length is the number of characters of the word.
+ */
+
+struct WordView {
+    int id;
+    const char *word;
+    int length;
+};
+typedef struct WordView WordView;
+
+/**
+ * @brief Creates an empty pool.
+ *
+ * @return The newly created pool.
+ */
+
+WordPool *initWordPool();
+
+/**
+ * @brief Copies a word to the end of the pool and returns its id.
+ *
+ * @param[in] pool The pool.
+ * @param[in] word The word, which does not need to be '\0' terminated.
+ * @param[in] length The number of characters of the word.
+ *
+ * @return The id of the new word.
+ */
+
+int internWord(WordPool *pool, const char *word, int length);
+
+/**
+ * @brief Returns a view of the word with the given id.
+ *
+ * @param[in] pool The pool.
+ * @param[in] id The id of the word. A word that was inserted into the Trie without the pool, and
+ * so was never interned, has no id; internTrie() gives it one.
+ */
+
+WordView poolView(WordPool *pool, int id);
+
+/**
+ * @brief Inserts a word into the Trie and interns it, unless the Trie already had it.
+ *
+ * The Trie holds the lowercase letters of the word the same way insert() does, and the pool keeps
+ * the same letters with the casing they were given in. When a word is inserted again, in any
+ * casing, the casing it was first interned with is kept.
+ *
+ * @param[in] root The root of the Trie.
+ * @param[in] pool The pool.
+ * @param[in] word The word to be inserted.
+ * @param[in] weight The weight to be added to the word.
+ *
+ * @return The id of the word.
+ */
+
+int insertInterned(Node *root, WordPool *pool, const char *word, unsigned int weight);
+
+/**
+ * @brief Interns every word of the Trie that does not have an id yet, for example the words of
+ * a Trie restored from a store, or words added with insert().
+ *
+ * @param[in] pool The pool.
+ * @param[in] root The root of the Trie.
+ *
+ * @return The number of words that were interned.
+ */
+
+int internTrie(WordPool *pool, Node *root);
+
+/**
+ * @brief Returns the first N matching words in the Trie for a given input word and N, as views
+ * into the pool. The results are the same words, in the same order, as those of predictN().
+ *
+ * @param[in] root Root node of the Trie. Every word of the Trie must be in the pool.
+ * @param[in] pool The pool.
+ * @param[in] word Word to be prefix matched. It is sanitized in place.
+ * @param[in] resultsLength The number of results to be returned.
+ * @param[out] views Receives the results, it must have room for resultsLength views.
+ *
+ * @return The number of views that were filled in.
+ */
+
+int predictViews(Node *root, WordPool *pool, string *word, int resultsLength, WordView *views);
+
+/**
+ * @brief Returns the N matching words in the Trie with the highest weights, as views into the
+ * pool. The results are the same words, in the same order, as those of predictRanked().
+ *
+ * @param[in] root Root node of the Trie. Every word of the Trie must be in the pool.
+ * @param[in] pool The pool.
+ * @param[in] word Word to be prefix matched. It is sanitized in place.
+ * @param[in] resultsLength The number of results to be returned.
+ * @param[out] views Receives the results, it must have room for resultsLength views.
+ *
+ * @return The number of views that were filled in.
+ */
+
+int predictRankedViews(Node *root, WordPool *pool, string *word, int resultsLength,
+                       WordView *views);
+
+/**
+ * @brief Returns the number of heap bytes that are held by the pool.
+ *
+ * @param[in] pool The pool.
+ */
+
+size_t poolMemory(WordPool *pool);
+
+/**
+ * @brief Reclaims all the memory held by the pool.
+ *
+ * @param[in] pool The pool.
+ */
+
+void delWordPool(WordPool *pool);
+
+/**
+ * @brief A function to test the word pool and all supported operations on it.
+ */
+
+void testWordPool();
+
+#endif
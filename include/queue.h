@@ -81,4 +81,10 @@ void addToQueue(Queue *queue, void *value);
 
 void removeFromQueue(Queue *queue);
 
+/**
+ * @brief A function to test the Queue implementation
+ */
+
+void testQueue();
+
 #endif
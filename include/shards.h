@@ -0,0 +1,124 @@
+/**
+ * @file shards.h
+ * @author Arjun Pathak
+ * @brief Declaration of functions for the sharded multi-dictionary container
+ *
+ * This header declares a container that holds many named Tries (shards), for example one per
+ * locale or per tenant, inside one process. Each shard is loaded from its own word file and can be
+ * loaded, replaced or unloaded without touching the others. Queries may be run over any chosen
+ * set of shards; the per-shard results are merged with a k-way heap into a single list that is in
+ * the same shortest-first order as predictN() results. Shards may be loaded, replaced and unloaded
+ * on one thread while queries run on others.
+ */
+
+#ifndef SHARDS_H
+#define SHARDS_H
+
+#include <pthread.h>
+#include <stdbool.h>
+
+#include "cus_string.h"
+#include "trie.h"
+
+/**
+ * @struct Shard
+ * @brief This structure holds a single named Trie.
+ *
+ * @var Shard::name
+ * Member name is the heap allocated name the shard is looked up by.
+ * @var Shard::root
+ * Member root is the root of the Trie that holds the words of the shard.
+ * @var Shard::wordsCount
+ * Member wordsCount is the number of words that were read into the shard.
+ */
+
+struct Shard {
+    char *name;
+    Node *root;
+    int wordsCount;
+};
+typedef struct Shard Shard;
+
+/**
+ * @struct ShardSet
+ * @brief This structure holds all the shards that are currently loaded.
+ *
+ * @var ShardSet::shards
+ * Member shards is the array of loaded shards.
+ * @var ShardSet::count
+ * Member count is the number of loaded shards.
+ * @var ShardSet::capacity
+ * Member capacity is the number of shards the array has room for.
+ * @var ShardSet::lock
+ * Member lock is held for reading by queries and for writing while a shard is swapped in or out.
+ */
+
+struct ShardSet {
+    Shard *shards;
+    int count;
+    int capacity;
+    pthread_rwlock_t lock;
+};
+typedef struct ShardSet ShardSet;
+
+/**
+ * @brief Creates an empty set of shards.
+ *
+ * @return The newly created set.
+ */
+
+ShardSet *initShardSet();
+
+/**
+ * @brief Loads the words of a file into a shard, replacing the shard if the name is taken.
+ *
+ * @param[in] set The set the shard belongs to.
+ * @param[in] name The name of the shard.
+ * @param[in] path The path to a newline terminated word file.
+ *
+ * @return The number of words that were loaded, or -1 if the file could not be opened.
+ */
+
+int loadShard(ShardSet *set, const char *name, const char *path);
+
+/**
+ * @brief Removes a shard from the set and reclaims its memory.
+ *
+ * @param[in] set The set the shard belongs to.
+ * @param[in] name The name of the shard.
+ *
+ * @return true if the shard was found and removed.
+ */
+
+bool unloadShard(ShardSet *set, const char *name);
+
+/**
+ * @brief Returns the first N matching words over a chosen set of shards.
+ *
+ * @param[in] set The set of shards.
+ * @param[in] names The names of the shards to be queried. If NULL, all shards are queried.
+ * @param[in] namesCount The number of entries in names.
+ * @param[in] word The word to be prefix matched.
+ * @param[in] resultsLength The number of results to be returned.
+ *
+ * @return A buffer of resultsLength entries, unused entries are set to NULL.
+ */
+
+char **predictShards(ShardSet *set, const char **names, int namesCount, string *word,
+                     int resultsLength);
+
+/**
+ * @brief Unloads all the shards and deletes the set.
+ *
+ * @param[in] set The set to be deleted.
+ */
+
+void delShardSet(ShardSet *set);
+
+/**
+ * @brief A function to test the shard set and all supported operations on it.
+ */
+
+void testShards();
+
+#endif
@@ -0,0 +1,129 @@
+/**
+ * @file store.h
+ * @author Arjun Pathak
+ * @brief Declaration of functions for the persistent Trie store
+ *
+ * This header declares a store that keeps a Trie on disk inside a directory, so that the words
+ * inserted at runtime survive a restart. Every insert is appended to a write-ahead log, and the
+ * log is fsync()ed once per group of inserts instead of once per insert. Once the log grows large
+ * compared to the Trie, the whole Trie is written out as a binary snapshot and a new, empty log is
+ * started. Recovery loads the latest snapshot and replays only the logs written after it, so the
+ * restart time depends on the size of the Trie and the recent inserts, not on the whole history.
+ */
+
+#ifndef STORE_H
+#define STORE_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "budget.h"
+#include "trie.h"
+
+/**
+ * @struct Store
+ * @brief This structure holds the open log and the bookkeeping of a store directory.
+ *
+ * @var Store::directory
+ * Member directory is the path to the directory the files of the store live in.
+ * @var Store::root
+ * Member root is the Trie that is persisted by the store.
+ * @var Store::generation
+ * Member generation is the number of the current log. A snapshot with generation g holds
+ * everything that was written to the logs before log g.
+ * @var Store::log
+ * Member log is the current log, opened for appending.
+ * @var Store::logBytes
+ * Member logBytes is the size of the current log.
+ * @var Store::snapshotBytes
+ * Member snapshotBytes is the size of the latest snapshot.
+ * @var Store::pending
+ * Member pending is the number of logged inserts that were not fsync()ed yet.
+ * @var Store::groupSize
+ * Member groupSize is the number of inserts after which the log is fsync()ed.
+ * @var Store::recovered
+ * Member recovered is set if a snapshot or a non empty log was found when the store was opened.
+ */
+
+struct Store {
+    char *directory;
+    Node *root;
+    unsigned long generation;
+    FILE *log;
+    long logBytes;
+    long snapshotBytes;
+    int pending;
+    int groupSize;
+    bool recovered;
+};
+typedef struct Store Store;
+
+/**
+ * @brief Opens a store directory and recovers the Trie that was persisted in it.
+ *
+ * @param[in] directory The path to an existing directory.
+ * @param[in] root An empty Trie that the persisted words are loaded into.
+ * @param[in] budget The budget of the Trie, which the persisted words are inserted through so
+ * that the Trie never goes over it while it is recovered, or NULL.
+ * @param[in] groupSize The number of inserts after which the log is fsync()ed.
+ *
+ * @return The opened store, or NULL if the files in the directory could not be read or created.
+ */
+
+Store *openStore(const char *directory, Node *root, TrieBudget *budget, int groupSize);
+
+/**
+ * @brief Returns true if the store had a snapshot or a non empty log to recover the Trie from.
+ *
+ * @param[in] store The store.
+ */
+
+bool storeHasData(Store *store);
+
+/**
+ * @brief Appends an insert to the log. The word must already have been inserted into the Trie.
+ *
+ * @param[in] store The store.
+ * @param[in] word The word that was inserted.
+ * @param[in] weight The weight the word was inserted with.
+ *
+ * @return false if the log could not be written.
+ */
+
+bool logInsert(Store *store, const char *word, unsigned int weight);
+
+/**
+ * @brief Forces the logged inserts that are still pending to disk.
+ *
+ * @param[in] store The store.
+ *
+ * @return false if the log could not be written.
+ */
+
+bool syncStore(Store *store);
+
+/**
+ * @brief Writes a snapshot of the whole Trie and starts a new, empty log.
+ *
+ * @param[in] store The store.
+ *
+ * @return false if the snapshot could not be written, in which case the old files stay in use.
+ */
+
+bool compactStore(Store *store);
+
+/**
+ * @brief Syncs the log and closes the store. The Trie itself is not deleted.
+ *
+ * @param[in] store The store.
+ */
+
+void closeStore(Store *store);
+
+/**
+ * @brief A function to test the store and all supported operations on it.
+ */
+
+void testStore();
+
+#endif
@@ -0,0 +1,95 @@
+/**
+ * @file suffix.h
+ * @author Arjun Pathak
+ * @brief Declaration of functions for the substring (infix) search index
+ *
+ * The Trie can only match words by their prefix. This header declares a suffix array that is
+ * built over the same dictionary, which allows matching any part of a word ("phone" finds
+ * "telephone"). Every word of the Trie is copied once into a single '\0' separated text buffer,
+ * and the sorted offsets of all suffixes of all words are stored in an int array. A query is two
+ * binary searches over that array, followed by a mapping from the matched offsets back to the
+ * words they belong to.
+ */
+
+#ifndef SUFFIX_H
+#define SUFFIX_H
+
+#include <stddef.h>
+
+#include "cus_string.h"
+#include "trie.h"
+
+/**
+ * @struct SuffixIndex
+ * @brief This structure holds the suffix array and the words it was built from.
+ *
+ * @var SuffixIndex::text
+ * Member text stores every word of the dictionary in alphabetical order, each one '\0' terminated.
+ * @var SuffixIndex::textLength
+ * Member textLength is the number of bytes used in text, including the terminators.
+ * @var SuffixIndex::suffixes
+ * Member suffixes holds the offsets into text of every suffix, in sorted order.
+ * @var SuffixIndex::suffixesCount
+ * Member suffixesCount is the number of entries in the suffixes array.
+ * @var SuffixIndex::wordStarts
+ * Member wordStarts holds the offset into text at which each word begins. The index into this
+ * array is the id of the word.
+ * @var SuffixIndex::wordsCount
+ * Member wordsCount is the number of words in the index.
+ */
+
+struct SuffixIndex {
+    char *text;
+    int textLength;
+    int *suffixes;
+    int suffixesCount;
+    int *wordStarts;
+    int wordsCount;
+};
+typedef struct SuffixIndex SuffixIndex;
+
+/**
+ * @brief Builds a substring index out of all the words stored in the Trie.
+ *
+ * @param[in] root The root of a populated Trie.
+ *
+ * @return The newly built index.
+ */
+
+SuffixIndex *initSuffixIndex(Node *root);
+
+/**
+ * @brief Returns the first N dictionary words that contain the given word anywhere inside them.
+ *
+ * @param[in] index The index to be searched.
+ * @param[in] word The infix to be matched. It is sanitized in place, like predictN() does.
+ * @param[in] resultsLength The maximum number of results to be returned.
+ *
+ * @return A buffer of resultsLength entries, unused entries are set to NULL.
+ */
+
+char **searchN(SuffixIndex *index, string *word, int resultsLength);
+
+/**
+ * @brief Returns the number of heap bytes that are held by the index.
+ *
+ * @param[in] index The index that is to be measured.
+ */
+
+size_t suffixIndexMemory(SuffixIndex *index);
+
+/**
+ * @brief Reclaims all the memory held by the index.
+ *
+ * @param[in] index The index to be deleted.
+ */
+
+void delSuffixIndex(SuffixIndex *index);
+
+/**
+ * @brief A function to test the suffix index and all supported operations on it.
+ */
+
+void testSuffixIndex();
+
+#endif
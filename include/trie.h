@@ -13,6 +13,7 @@
 #ifndef TRIE_H
 #define TRIE_H
 
+#include <stdatomic.h>
 #include <stdbool.h>
 #include "cus_string.h"
 
@@ -25,11 +26,25 @@
  * @var Node::isEndOfWord
  * Member isEndOfWord is a boolean value indicating if the current Node marks the end of a word or
  * not.
+ * @var Node::weight
+ * Member weight is the total weight the word ending at this Node was inserted with, for example
+ * the number of times it was seen. It is 0 for Nodes that do not end a word.
+ * @var Node::maxWeight
+ * Member maxWeight is at least the weight of every word that ends at or below this Node, so that
+ * a search for the highest weights can skip the subtrees that cannot hold one. Evicting a word
+ * does not lower it, which keeps it an upper bound. It fits in the padding at the end of the
+ * Node, so it costs no memory.
+ * @var Node::id
+ * Member id is the id of the word ending at this Node in the word pool. It is -1 for Nodes that
+ * were never interned.
  */
 
 struct Node {
     struct Node* children[26];
     bool isEndOfWord;
+    unsigned int weight;
+    unsigned int maxWeight;
+    int id;
 };
 typedef struct Node Node;
 
@@ -50,6 +65,19 @@ Node *initTrie();
 
 void insert(Node *root, const char *word);
 
+/**
+ * @brief This function is used to insert a word into the Trie with a weight. Inserting a word that
+ * is already in the Trie adds the weight to the weight it has.
+ *
+ * @param[in] root The root node of the Trie Structure.
+ * @param[in] word The word that is to be inserted into the Trie.
+ * @param[in] weight The weight to be added to the word.
+ *
+ * @return The number of Nodes that were created for the word.
+ */
+
+int insertWeighted(Node *root, const char *word, unsigned int weight);
+
 /**
  * @brief This function is used to print to stdout, the matching words from
  * the Trie structure.
@@ -72,6 +100,149 @@ void predict(Node *root, string *word);
 
 char **predictN(Node *root, string *word, int resultsLength);
 
+/**
+ * @brief This function returns the same words as predictN(), in the same order, using an
+ * iterative deepening depth-first search.
+ *
+ * Where the BFS of predictN() holds a whole level of the subtree at once, which on a short prefix
+ * of a large dictionary runs into hundreds of thousands of entries, this search only holds the
+ * path down to the Node it visits. Its memory is bounded by the length of the longest word, at
+ * the cost of walking the upper levels again for every level it goes down.
+ *
+ * @param[in] root Root node of the Trie.
+ * @param[in] word Word to be prefix matched. It is sanitized in place.
+ * @param[in] resultsLength The number of results to be returned.
+ *
+ * @return The first resultsLength words matched in the Trie.
+ */
+
+char **predictDeepening(Node *root, string *word, int resultsLength);
+
+/**
+ * @brief A search that returns the matching words one at a time. Its layout is private to the
+ * Trie implementation.
+ */
+
+typedef struct Completion Completion;
+
+/**
+ * @brief This function starts a search that returns the matching words one at a time, in the
+ * order of predictN().
+ *
+ * The search is a BFS that pauses after every matching word, so a caller that merges several
+ * Tries, or does not know up front how many words it needs, only pays for the words it takes.
+ *
+ * @param[in] root Root node of the Trie. It must not be changed while the search is in use.
+ * @param[in] word Word to be prefix matched. It is sanitized in place.
+ *
+ * @return The newly created search.
+ */
+
+Completion *initCompletion(Node *root, string *word);
+
+/**
+ * @brief This function resumes the search until it reaches the next matching word.
+ *
+ * @param[in] completion The search.
+ *
+ * @return The next matching word, which the caller frees, or NULL once there are no more.
+ */
+
+char *nextCompletion(Completion *completion);
+
+/**
+ * @brief This function reclaims the memory held by a search.
+ *
+ * @param[in] completion The search.
+ */
+
+void delCompletion(Completion *completion);
+
+/**
+ * @brief This function returns the Nodes the first N matching words end at, in the order of
+ * predictN(), without building the words themselves.
+ *
+ * @param[in] root Root node of the Trie.
+ * @param[in] word Word to be prefix matched.
+ * @param[in] resultsLength The number of results to be returned.
+ * @param[out] results Receives the Nodes, it must have room for resultsLength of them.
+ *
+ * @return The number of Nodes that were found.
+ */
+
+int predictNodes(Node *root, string *word, int resultsLength, Node **results);
+
+/**
+ * @brief This function returns the Nodes of the first N matching words, the same ones as
+ * predictNodes(), unless another thread cancels the search first.
+ *
+ * The flag is checked inside the traversal loop, so a search over a broad prefix stops shortly
+ * after the flag is set instead of running until it has found all of its words.
+ *
+ * @param[in] root Root node of the Trie.
+ * @param[in] word Word to be prefix matched. It is sanitized in place.
+ * @param[in] resultsLength The number of results to be returned.
+ * @param[out] results Receives the Nodes, it must have room for resultsLength of them.
+ * @param[in] cancel A flag that another thread sets to stop the search, or NULL.
+ *
+ * @return The number of Nodes that were found, or -1 if the search was cancelled.
+ */
+
+int predictNodesCancellable(Node *root, string *word, int resultsLength, Node **results,
+                            const atomic_bool *cancel);
+
+/**
+ * @brief This function returns the N matching words with the highest weights, the highest first.
+ *
+ * Words of the same weight come in the order of predictN(), shortest first and then
+ * alphabetically, so on a Trie where every word has the same weight the results are the same as
+ * those of predictN(). Finding the highest weights takes a walk over every Node below the matched
+ * prefix, which keeps only the best N words seen so far in a bounded heap, so it costs more than
+ * the BFS of predictN(), which stops at the first N words.
+ *
+ * @param[in] root Root node of the Trie.
+ * @param[in] word Word to be prefix matched. It is sanitized in place.
+ * @param[in] resultsLength The number of results to be returned.
+ *
+ * @return The matched words, laid out the same way as the buffers returned by predictN().
+ */
+
+char **predictRanked(Node *root, string *word, int resultsLength);
+
+/**
+ * @brief This function returns the Nodes of the N matching words with the highest weights, the
+ * same ones as predictRanked(), unless another thread cancels the search first.
+ *
+ * @param[in] root Root node of the Trie.
+ * @param[in] word Word to be prefix matched. It is sanitized in place.
+ * @param[in] resultsLength The number of results to be returned.
+ * @param[out] results Receives the Nodes, it must have room for resultsLength of them.
+ * @param[in] cancel A flag that another thread sets to stop the search, or NULL.
+ *
+ * @return The number of Nodes that were found, or -1 if the search was cancelled.
+ */
+
+int predictRankedNodes(Node *root, string *word, int resultsLength, Node **results,
+                       const atomic_bool *cancel);
+
+/**
+ * @brief This function answers many queries at once, with the same results as predictN().
+ *
+ * The queries are walked through the Trie in an interleaved group. Every query advances by one
+ * node per turn and prefetches the node it needs next before the turn passes to the next query,
+ * so the memory loads of the whole group overlap instead of stalling one after the other.
+ *
+ * @param[in] root Root node of the Trie.
+ * @param[in] words The words to be prefix matched. Each one is sanitized in place.
+ * @param[in] wordsCount The number of words.
+ * @param[in] resultsLength The number of results to be returned per word.
+ * @param[out] results Receives one buffer of resultsLength entries per word, laid out the same
+ * way as the buffers returned by predictN().
+ */
+
+void predictNBatch(Node *root, string **words, int wordsCount, int resultsLength,
+                   char ***results);
+
 /**
  * @brief Takes in the root of the Trie and deletes all the nodes.
  * 
@@ -80,4 +251,10 @@ char **predictN(Node *root, string *word, int resultsLength);
 
 void delTrie(Node *root);
 
+/**
+ * @brief A function to test the Trie Structure and all supported operations on it.
+ */
+
+void testTrie();
+
 #endif
@@ -0,0 +1,36 @@
+/**
+ * @file tui.h
+ * @author Arjun Pathak
+ * @brief Declaration of functions for the ncurses terminal interface
+ *
+ * This header declares a full screen interface that completes the query on every keystroke. The
+ * keys are read and the screen is drawn on the calling thread, while the completions are searched
+ * for on a worker thread, so a slow search over a broad prefix never holds up typing. Every new
+ * keystroke cancels the search that is still running for an older query, and only the results of
+ * the newest query are ever drawn, together with how long they took.
+ */
+
+#ifndef TUI_H
+#define TUI_H
+
+#include <stdbool.h>
+
+#include "pool.h"
+#include "trie.h"
+
+/**
+ * @brief Runs the terminal interface until the user quits with Esc or Ctrl-D.
+ *
+ * @param[in] root The root of the Trie. It must not be changed while the interface runs.
+ * @param[in] pool The pool every word of the Trie is interned in.
+ * @param[in] resultsLength The number of results shown per query.
+ * @param[in] ranked Whether the words with the highest weights are shown instead of the first
+ * ones in the order of predictN().
+ *
+ * @return The number of queries whose results were drawn, or -1 if the terminal could not be
+ * set up.
+ */
+
+long runTui(Node *root, WordPool *pool, int resultsLength, bool ranked);
+
+#endif
@@ -0,0 +1,568 @@
+/**
+ * @file batch.c
+ * @author Arjun Pathak
+ * @brief This file contains the implementation of the streaming batch mode.
+ *
+ * This file contains the implementations of the functions declared in the batch.h header file.
+ * The input is cut into blocks of whole lines, every block of queries is answered into a block of
+ * result lines, and the result blocks are written out in the order of the input. On a machine
+ * with a single core, all of this runs on the calling thread: there is nothing for other threads
+ * to overlap with, and merely having them makes every allocation of the queries take a lock. With
+ * more cores, a reader thread fills the input blocks, one query thread per core answers them, and
+ * a writer thread puts the result blocks back in order through a window of slots. Input blocks are
+ * kept small so that even a short input is spread over every query thread, and the window bounds
+ * how far the query threads may run ahead of the writer, so only a few megabytes are in flight at
+ * any time.
+ */
+
+#define _GNU_SOURCE
+
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "batch.h"
+#include "queue.h"
+
+#define BLOCK_SIZE (64 << 10)
+#define BLOCKS_PER_THREAD 4
+#define LONG_QUERY_LENGTH 4
+#define INTERLEAVE_MEMORY (16 << 20)
+
+/**
+ * @struct Block
+ * @brief A block of bytes that is handed from one thread to the next.
+ *
+ * @var Block::data
+ * Member data holds the bytes of the block.
+ * @var Block::length
+ * Member length is the number of bytes used.
+ * @var Block::capacity
+ * Member capacity is the number of bytes data has room for.
+ * @var Block::sequence
+ * Member sequence is the position of the block in the input, which its result block keeps.
+ * @var Block::last
+ * Member last is set on the empty block that marks the end of the stream.
+ */
+
+struct Block {
+    char *data;
+    size_t length;
+    size_t capacity;
+    size_t sequence;
+    bool last;
+};
+typedef struct Block Block;
+
+/**
+ * @struct Channel
+ * @brief A bounded queue of blocks that is safe to share between threads.
+ */
+
+struct Channel {
+    Queue *queue;
+    int count;
+    int capacity;
+    pthread_mutex_t lock;
+    pthread_cond_t notEmpty;
+    pthread_cond_t notFull;
+};
+typedef struct Channel Channel;
+
+/**
+ * @struct Reorder
+ * @brief The window of result blocks that are answered but not written yet.
+ *
+ * @var Reorder::slots
+ * Member slots holds the result block of sequence n in slot n modulo the window, or NULL.
+ * @var Reorder::window
+ * Member window is the number of slots.
+ * @var Reorder::next
+ * Member next is the sequence of the next block to be written.
+ */
+
+struct Reorder {
+    Block **slots;
+    size_t window;
+    size_t next;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+};
+typedef struct Reorder Reorder;
+
+/**
+ * @struct Pipeline
+ * @brief The state shared by the reader, query and writer threads.
+ *
+ * @var Pipeline::carry
+ * Member carry holds the unfinished line at the end of the last input block.
+ * @var Pipeline::blocks
+ * Member blocks is the number of input blocks read so far.
+ * @var Pipeline::interleave
+ * Member interleave is true if the long queries are answered through engineCompleteBatch().
+ */
+
+struct Pipeline {
+    FILE *input;
+    FILE *output;
+    Engine *engine;
+    ResultCache *cache;
+    int results;
+    BatchFormat format;
+    char *carry;
+    size_t carryLength;
+    size_t blocks;
+    bool interleave;
+    Channel toQuery;
+    Reorder toWriter;
+    bool writeFailed;
+};
+typedef struct Pipeline Pipeline;
+
+/**
+ * @struct QueryThread
+ * @brief A query thread and the number of queries it answered.
+ */
+
+struct QueryThread {
+    Pipeline *pipeline;
+    pthread_t thread;
+    long queries;
+};
+typedef struct QueryThread QueryThread;
+
+static Block *initBlock(size_t capacity) {
+    Block *block = malloc(sizeof(Block));
+    block->data = malloc(capacity);
+    block->length = 0;
+    block->capacity = capacity;
+    block->sequence = 0;
+    block->last = false;
+    return block;
+}
+
+static void delBlock(Block *block) {
+    free(block->data);
+    free(block);
+}
+
+static void initChannel(Channel *channel, int capacity) {
+    channel->queue = initQueue(NULL);
+    channel->count = 0;
+    channel->capacity = capacity;
+    pthread_mutex_init(&channel->lock, NULL);
+    pthread_cond_init(&channel->notEmpty, NULL);
+    pthread_cond_init(&channel->notFull, NULL);
+}
+
+static void destroyChannel(Channel *channel) {
+    deleteQueue(channel->queue);
+    pthread_mutex_destroy(&channel->lock);
+    pthread_cond_destroy(&channel->notEmpty);
+    pthread_cond_destroy(&channel->notFull);
+}
+
+/**
+ * @brief A helper function that adds a block to a channel, waiting while the channel is full.
+ */
+
+static void sendBlock(Channel *channel, Block *block) {
+    pthread_mutex_lock(&channel->lock);
+    while (channel->count == channel->capacity) {
+        pthread_cond_wait(&channel->notFull, &channel->lock);
+    }
+    addToQueue(channel->queue, block);
+    channel->count++;
+    pthread_cond_signal(&channel->notEmpty);
+    pthread_mutex_unlock(&channel->lock);
+}
+
+/**
+ * @brief A helper function that takes a block out of a channel, waiting while it is empty.
+ */
+
+static Block *receiveBlock(Channel *channel) {
+    pthread_mutex_lock(&channel->lock);
+    while (channel->count == 0) {
+        pthread_cond_wait(&channel->notEmpty, &channel->lock);
+    }
+    Block *block = channel->queue->front->value;
+    removeFromQueue(channel->queue);
+    channel->count--;
+    pthread_cond_signal(&channel->notFull);
+    pthread_mutex_unlock(&channel->lock);
+    return block;
+}
+
+static void initReorder(Reorder *reorder, size_t window) {
+    reorder->slots = calloc(window, sizeof(Block *));
+    reorder->window = window;
+    reorder->next = 0;
+    pthread_mutex_init(&reorder->lock, NULL);
+    pthread_cond_init(&reorder->changed, NULL);
+}
+
+static void destroyReorder(Reorder *reorder) {
+    free(reorder->slots);
+    pthread_mutex_destroy(&reorder->lock);
+    pthread_cond_destroy(&reorder->changed);
+}
+
+/**
+ * @brief A helper function that puts a result block into its slot, waiting while the block is
+ * too far ahead of the writer.
+ *
+ * The block the writer waits for always has a slot, so the window can never fill up with blocks
+ * that are all waiting on it.
+ */
+
+static void putResults(Reorder *reorder, Block *block) {
+    pthread_mutex_lock(&reorder->lock);
+    while (block->sequence >= reorder->next + reorder->window) {
+        pthread_cond_wait(&reorder->changed, &reorder->lock);
+    }
+    reorder->slots[block->sequence % reorder->window] = block;
+    pthread_cond_broadcast(&reorder->changed);
+    pthread_mutex_unlock(&reorder->lock);
+}
+
+/**
+ * @brief A helper function that takes the next result block in the order of the input, waiting
+ * until it is answered.
+ */
+
+static Block *takeResults(Reorder *reorder) {
+    pthread_mutex_lock(&reorder->lock);
+    Block **slot = &reorder->slots[reorder->next % reorder->window];
+    while (*slot == NULL) {
+        pthread_cond_wait(&reorder->changed, &reorder->lock);
+    }
+    Block *block = *slot;
+    *slot = NULL;
+    reorder->next++;
+    pthread_cond_broadcast(&reorder->changed);
+    pthread_mutex_unlock(&reorder->lock);
+    return block;
+}
+
+/**
+ * @brief A helper function that reads the next block of whole lines.
+ *
+ * The block is cut after its last newline and the unfinished line is carried over to the next
+ * block. A missing newline at the end of the stream is added.
+ *
+ * @param[in, out] pipeline The pipeline.
+ *
+ * @return The next block, or a block marked last once the stream is exhausted.
+ */
+
+static Block *readBlock(Pipeline *pipeline) {
+    while (true) {
+        size_t carryLength = pipeline->carryLength;
+        Block *block = initBlock(carryLength + BLOCK_SIZE + 1);
+        if (carryLength) {
+            memcpy(block->data, pipeline->carry, carryLength);
+        }
+        size_t read = fread(block->data + carryLength, 1, BLOCK_SIZE, pipeline->input);
+        size_t total = carryLength + read;
+        block->sequence = pipeline->blocks;
+
+        if (read == 0) {
+            pipeline->carryLength = 0;
+            if (total) {
+                block->data[total] = '\n';
+                block->length = total + 1;
+            } else {
+                block->last = true;
+            }
+            pipeline->blocks += !block->last;
+            return block;
+        }
+
+        char *newline = memrchr(block->data, '\n', total);
+        size_t used = newline ? (size_t)(newline - block->data) + 1 : 0;
+        pipeline->carry = realloc(pipeline->carry, total - used + 1);
+        memcpy(pipeline->carry, block->data + used, total - used);
+        pipeline->carryLength = total - used;
+        if (used == 0) {
+            delBlock(block);
+            continue;
+        }
+        block->length = used;
+        pipeline->blocks++;
+        return block;
+    }
+}
+
+/**
+ * @brief A helper function that writes a result block out.
+ */
+
+static void writeBlock(Pipeline *pipeline, Block *block) {
+    if (block->length && fwrite(block->data, 1, block->length, pipeline->output) != block->length) {
+        pipeline->writeFailed = true;
+    }
+}
+
+/**
+ * @brief A helper function that copies bytes to the end of a block, growing it when needed.
+ */
+
+static void put(Block *block, const char *bytes, size_t length) {
+    if (block->length + length > block->capacity) {
+        while (block->length + length > block->capacity) {
+            block->capacity *= 2;
+        }
+        block->data = realloc(block->data, block->capacity);
+    }
+    memcpy(block->data + block->length, bytes, length);
+    block->length += length;
+}
+
+/**
+ * @brief A helper function that formats the results of one query as a line of the output.
+ *
+ * The sanitized query is written instead of the raw input line. It only holds lowercase letters,
+ * as do the results, so neither format needs any escaping.
+ */
+
+static void formatResults(Block *block, BatchFormat format, string *query, char **results,
+                          int resultsLength) {
+    if (format == BATCH_JSON) {
+        put(block, "{\"query\":\"", 10);
+        put(block, query->array, query->length);
+        put(block, "\",\"results\":[", 13);
+        for (int i = 0; i < resultsLength && results[i]; i++) {
+            if (i) {
+                put(block, ",", 1);
+            }
+            put(block, "\"", 1);
+            put(block, results[i], strlen(results[i]));
+            put(block, "\"", 1);
+        }
+        put(block, "]}\n", 3);
+        return;
+    }
+
+    put(block, query->array, query->length);
+    for (int i = 0; i < resultsLength && results[i]; i++) {
+        put(block, "\t", 1);
+        put(block, results[i], strlen(results[i]));
+    }
+    put(block, "\n", 1);
+}
+
+/**
+ * @brief A helper function that answers every query of an input block.
+ *
+ * Queries are answered one by one, through the cache if there is one. When the engine is too
+ * large for the CPU cache, queries of at least LONG_QUERY_LENGTH letters are instead answered
+ * together through engineCompleteBatch(): the Nodes of a long prefix are spread over the whole
+ * structure, so interleaving those lookups hides their cache misses. The Nodes of a short prefix,
+ * or of any prefix of a small dictionary, are already in the cache, and interleaving them only
+ * adds work.
+ *
+ * @param[in] pipeline The pipeline.
+ * @param[in] block The input block, whose lines are cut in place.
+ * @param[out] queries Incremented by the number of queries of the block.
+ *
+ * @return The result block, with the sequence of the input block.
+ */
+
+static Block *answerBlock(Pipeline *pipeline, Block *block, long *queries) {
+    Block *out = initBlock(4 * BLOCK_SIZE);
+    out->sequence = block->sequence;
+    int count = 0, capacity = 256, longCount = 0;
+    char **starts = malloc(sizeof(char *) * capacity);
+    size_t *lengths = malloc(sizeof(size_t) * capacity);
+    string **longLines = malloc(sizeof(string *) * capacity);
+    char *line = block->data, *end = block->data + block->length;
+    while (line < end) {
+        char *newline = memchr(line, '\n', end - line);
+        size_t length = newline - line;
+        if (length && line[length - 1] == '\r') {
+            length--;
+        }
+        line[length] = '\0';
+        if (count == capacity) {
+            capacity *= 2;
+            starts = realloc(starts, sizeof(char *) * capacity);
+            lengths = realloc(lengths, sizeof(size_t) * capacity);
+            longLines = realloc(longLines, sizeof(string *) * capacity);
+        }
+        starts[count] = line;
+        lengths[count++] = length;
+        if (pipeline->interleave && length >= LONG_QUERY_LENGTH) {
+            longLines[longCount++] = initString(line, length);
+        }
+        line = newline + 1;
+    }
+    char ***longBuffers = malloc(sizeof(char **) * (longCount + 1));
+    engineCompleteBatch(pipeline->engine, longLines, longCount, pipeline->results, longBuffers);
+
+    longCount = 0;
+    for (int i = 0; i < count; i++) {
+        string *query;
+        char **buffer;
+        if (pipeline->cache) {
+            query = initString(starts[i], lengths[i]);
+            buffer = cachedPredictN(pipeline->cache, engineTrie(pipeline->engine), query,
+                                    pipeline->results);
+        } else if (pipeline->interleave && lengths[i] >= LONG_QUERY_LENGTH) {
+            query = longLines[longCount];
+            buffer = longBuffers[longCount++];
+        } else {
+            query = initString(starts[i], lengths[i]);
+            buffer = engineComplete(pipeline->engine, query, pipeline->results);
+        }
+        formatResults(out, pipeline->format, query, buffer, pipeline->results);
+        for (int j = 0; j < pipeline->results; j++) {
+            free(buffer[j]);
+        }
+        free(buffer);
+        delString(query);
+    }
+    *queries += count;
+    free(longBuffers);
+    free(longLines);
+    free(lengths);
+    free(starts);
+    return out;
+}
+
+/**
+ * @brief The reader thread, which cuts the input stream into blocks of whole lines.
+ *
+ * @param[in] arg The pipeline.
+ */
+
+static void *readBlocks(void *arg) {
+    Pipeline *pipeline = arg;
+    Block *block;
+    do {
+        block = readBlock(pipeline);
+        sendBlock(&pipeline->toQuery, block);
+    } while (!block->last);
+    return NULL;
+}
+
+/**
+ * @brief A query thread, which answers input blocks until it takes the last one.
+ *
+ * The block marking the end of the stream is put back for the next query thread, so every query
+ * thread sees it and the last one is left in the channel once all of them are done.
+ *
+ * @param[in] arg The query thread.
+ */
+
+static void *answerBlocks(void *arg) {
+    QueryThread *self = arg;
+    Pipeline *pipeline = self->pipeline;
+    while (true) {
+        Block *block = receiveBlock(&pipeline->toQuery);
+        if (block->last) {
+            sendBlock(&pipeline->toQuery, block);
+            break;
+        }
+        putResults(&pipeline->toWriter, answerBlock(pipeline, block, &self->queries));
+        delBlock(block);
+    }
+    return NULL;
+}
+
+/**
+ * @brief The writer thread, which writes out the result blocks in the order of the input.
+ *
+ * @param[in] arg The pipeline.
+ */
+
+static void *writeBlocks(void *arg) {
+    Pipeline *pipeline = arg;
+    while (true) {
+        Block *block = takeResults(&pipeline->toWriter);
+        bool last = block->last;
+        writeBlock(pipeline, block);
+        delBlock(block);
+        if (last) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Answers every query of the input stream and writes the results to the output stream.
+ *
+ * The cache is not safe to share between threads, so with a cache a single query thread answers
+ * every block, while the reader and writer threads still take the reads and writes off it.
+ *
+ * @param[in] engine The engine that answers the queries.
+ * @param[in] cache An optional result cache to answer the queries through, or NULL. The cache
+ * needs the pointer Trie of the engine.
+ * @param[in] results The number of results per query.
+ * @param[in] format The format of the result lines.
+ * @param[in] input The stream the queries are read from.
+ * @param[in] output The stream the results are written to.
+ *
+ * @return The number of queries that were answered, or -1 if the results could not be written.
+ */
+
+long runBatch(Engine *engine, ResultCache *cache, int results, BatchFormat format,
+              FILE *input, FILE *output) {
+    Pipeline pipeline = {
+        .input = input,
+        .output = output,
+        .engine = engine,
+        .cache = cache,
+        .results = results,
+        .format = format,
+        .interleave = cache == NULL && engineMemory(engine) > INTERLEAVE_MEMORY,
+    };
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    long queries = 0;
+
+    if (cores <= 1) {
+        Block *block;
+        while (!(block = readBlock(&pipeline))->last) {
+            Block *out = answerBlock(&pipeline, block, &queries);
+            writeBlock(&pipeline, out);
+            delBlock(out);
+            delBlock(block);
+        }
+        delBlock(block);
+    } else {
+        int threadsCount = cache ? 1 : cores;
+        initChannel(&pipeline.toQuery, BLOCKS_PER_THREAD * threadsCount);
+        initReorder(&pipeline.toWriter, BLOCKS_PER_THREAD * threadsCount);
+        pthread_t reader, writer;
+        pthread_create(&reader, NULL, readBlocks, &pipeline);
+        pthread_create(&writer, NULL, writeBlocks, &pipeline);
+        QueryThread *threads = calloc(threadsCount, sizeof(QueryThread));
+        for (int i = 0; i < threadsCount; i++) {
+            threads[i].pipeline = &pipeline;
+            pthread_create(&threads[i].thread, NULL, answerBlocks, &threads[i]);
+        }
+        for (int i = 0; i < threadsCount; i++) {
+            pthread_join(threads[i].thread, NULL);
+            queries += threads[i].queries;
+        }
+        pthread_join(reader, NULL);
+
+        Block *last = receiveBlock(&pipeline.toQuery);
+        last->sequence = pipeline.blocks;
+        putResults(&pipeline.toWriter, last);
+        pthread_join(writer, NULL);
+        free(threads);
+        destroyChannel(&pipeline.toQuery);
+        destroyReorder(&pipeline.toWriter);
+    }
+    free(pipeline.carry);
+
+    if (fflush(output) != 0) {
+        pipeline.writeFailed = true;
+    }
+    return pipeline.writeFailed ? -1 : queries;
+}
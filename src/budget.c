@@ -0,0 +1,356 @@
+/**
+ * @file budget.c
+ * @author Arjun Pathak
+ * @brief This file contains the implementation of the memory budgeted Trie.
+ *
+ * This file contains the implementations of the functions declared in the budget.h header file.
+ * Every word gets a rank out of its weight and its length, so that evicting the words of the
+ * lowest ranks first evicts the lowest weights first and, among equal weights, the longest words
+ * first. A Node can be freed once every word below it is evicted, that is once the cutoff rank
+ * passes the highest rank below the Node. One walk of the Trie therefore gives, for every rank,
+ * exactly how many Nodes would be freed by evicting up to it, and a second walk evicts the words
+ * below the lowest cutoff that frees enough Nodes and frees their branches. The words of the
+ * cutoff rank itself are only evicted for as long as the Trie is still over its target, so a
+ * dictionary where every word has the same weight loses some of its longest words, not all of
+ * them. The word being inserted is kept out of both walks, so an insert never evicts the word it
+ * adds to and its weight keeps counting up.
+ */
+
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "budget.h"
+
+#define LOW_WATER_PERCENT 75
+#define RANK_DEPTHS 64
+#define RANK_WINDOW 4096
+
+/**
+ * @brief A helper function that returns the eviction rank of a word, lowest first.
+ *
+ * Words longer than RANK_DEPTHS - 1 letters share the rank of that length.
+ */
+
+static uint64_t wordRank(unsigned int weight, int depth) {
+    int clamped = depth < RANK_DEPTHS - 1 ? depth : RANK_DEPTHS - 1;
+    return (uint64_t)weight * RANK_DEPTHS + (RANK_DEPTHS - 1 - clamped);
+}
+
+static bool isLetter(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+/**
+ * @brief A helper function that follows the word that must not be evicted down to a child.
+ *
+ * @param[in] keep The letters of the kept word below the current Node, or NULL if the Node is not
+ * on its path.
+ * @param[in] letter The index of the child.
+ *
+ * @return The letters of the kept word below the child, or NULL if the child is not on its path.
+ */
+
+static const char *keptBelow(const char *keep, int letter) {
+    if (keep && isLetter(*keep) && (*keep | 0x20) - 'a' == letter) {
+        return keep + 1;
+    }
+    return NULL;
+}
+
+/**
+ * @brief A helper function that tells whether a Node ends the word that must not be evicted.
+ */
+
+static bool isKept(Node *node, const char *keep) {
+    return keep && !isLetter(*keep) && node->isEndOfWord;
+}
+
+static size_t countNodes(Node *node) {
+    size_t count = 1;
+    for (int i = 0; i < 26; i++) {
+        if (node->children[i]) {
+            count += countNodes(node->children[i]);
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief A helper function that returns how many Nodes inserting a word would create.
+ */
+
+static size_t missingNodes(Node *root, const char *word) {
+    Node *current = root;
+    size_t missing = 0;
+    for (const char *c = word; isLetter(*c); c++) {
+        current = current ? current->children[(*c | 0x20) - 'a'] : NULL;
+        missing += current == NULL;
+    }
+    return missing;
+}
+
+/**
+ * @brief A helper function that counts the Nodes below the root by the highest rank below them.
+ *
+ * The Nodes on the path of the kept word are never freed, so they are left out of the histogram.
+ *
+ * @param[in] node The Trie Node being visited.
+ * @param[in] depth The depth of the Node, which is the length of the word it ends.
+ * @param[in] keep The letters of the kept word below the Node, or NULL if it is not on its path.
+ * @param[in] base The lowest rank of the window being counted.
+ * @param[in, out] histogram The number of Nodes for each rank of the window.
+ * @param[in, out] next The lowest rank above the window that a Node has, for the next window.
+ *
+ * @return One more than the highest rank of the words below the Node, 0 if it has none, or
+ * UINT64_MAX if the kept word is below it.
+ */
+
+static uint64_t rankSubtree(Node *node, int depth, const char *keep, uint64_t base,
+                            size_t *histogram, uint64_t *next) {
+    uint64_t highest = 0;
+    if (isKept(node, keep)) {
+        highest = UINT64_MAX;
+    } else if (node->isEndOfWord && depth > 0) {
+        highest = wordRank(node->weight, depth) + 1;
+    }
+    for (int i = 0; i < 26; i++) {
+        if (node->children[i]) {
+            uint64_t child = rankSubtree(node->children[i], depth + 1, keptBelow(keep, i), base,
+                                         histogram, next);
+            highest = child > highest ? child : highest;
+        }
+    }
+    if (depth > 0 && highest != UINT64_MAX) {
+        uint64_t rank = highest ? highest - 1 : 0;
+        if (rank >= base && rank - base < RANK_WINDOW) {
+            histogram[rank - base]++;
+        } else if (rank >= base && rank < *next) {
+            *next = rank;
+        }
+    }
+    return highest;
+}
+
+/**
+ * @brief A helper function that evicts the words up to a cutoff rank and frees their branches.
+ *
+ * @param[in, out] budget The budget.
+ * @param[in] node The Trie Node being visited.
+ * @param[in] depth The depth of the Node.
+ * @param[in] keep The letters of the kept word below the Node, or NULL if it is not on its path.
+ * @param[in] cutoff The highest rank that is evicted.
+ * @param[in] target The number of Nodes above which words of the cutoff rank are still evicted.
+ * @param[in, out] evicted The number of words evicted so far.
+ *
+ * @return true if no word is left below the Node, so that it can be freed.
+ */
+
+static bool pruneSubtree(TrieBudget *budget, Node *node, int depth, const char *keep,
+                         uint64_t cutoff, size_t target, long *evicted) {
+    bool empty = true;
+    if (node->isEndOfWord) {
+        uint64_t rank = wordRank(node->weight, depth);
+        if (depth > 0 && !isKept(node, keep)
+            && (rank < cutoff || (rank == cutoff && budget->nodesCount > target))) {
+            node->isEndOfWord = false;
+            node->weight = 0;
+            (*evicted)++;
+        } else {
+            empty = false;
+        }
+    }
+    for (int i = 0; i < 26; i++) {
+        if (node->children[i] == NULL) {
+            continue;
+        }
+        if (pruneSubtree(budget, node->children[i], depth + 1, keptBelow(keep, i), cutoff, target,
+                         evicted)) {
+            free(node->children[i]);
+            node->children[i] = NULL;
+            budget->nodesCount--;
+        } else {
+            empty = false;
+        }
+    }
+    return empty;
+}
+
+/**
+ * @brief A helper function that evicts the lowest ranked words until at least N Nodes are freed.
+ *
+ * The ranks are counted one window at a time, starting with the lowest ranks, so the histogram
+ * stays small however large the weights are. Most Tries only need the first window.
+ *
+ * @param[in, out] budget The budget.
+ * @param[in] keep The word that must not be evicted.
+ * @param[in] needed The number of Nodes to be freed, less than the number of Nodes of the Trie.
+ *
+ * @return The number of words that were evicted.
+ */
+
+static long evictNodes(TrieBudget *budget, const char *keep, size_t needed) {
+    size_t *histogram = malloc(sizeof(size_t) * RANK_WINDOW);
+    size_t freed = 0;
+    uint64_t base = 0, cutoff = UINT64_MAX;
+    while (cutoff == UINT64_MAX) {
+        uint64_t next = UINT64_MAX;
+        memset(histogram, 0, sizeof(size_t) * RANK_WINDOW);
+        rankSubtree(budget->root, 0, keep, base, histogram, &next);
+        for (int i = 0; i < RANK_WINDOW && cutoff == UINT64_MAX; i++) {
+            freed += histogram[i];
+            if (freed >= needed) {
+                cutoff = base + i;
+            }
+        }
+        if (next == UINT64_MAX) {
+            break;
+        }
+        base = next;
+    }
+    free(histogram);
+
+    long evicted = 0;
+    pruneSubtree(budget, budget->root, 0, keep, cutoff, budget->nodesCount - needed, &evicted);
+    budget->evictedCount += evicted;
+    budget->evictions++;
+    return evicted;
+}
+
+/**
+ * @brief A helper function that evicts words until a word fits in the budget.
+ *
+ * @param[in, out] budget The budget.
+ * @param[in] word The word about to be inserted, which is not evicted itself, or an empty word to
+ * only get under the budget.
+ *
+ * @return The number of words that were evicted, or -1 if the word can never fit.
+ */
+
+static long makeRoom(TrieBudget *budget, const char *word) {
+    size_t limitNodes = budget->limit / sizeof(Node);
+    size_t lowNodes = limitNodes * LOW_WATER_PERCENT / 100;
+    size_t letters = 0;
+    while (isLetter(word[letters])) {
+        letters++;
+    }
+    if (1 + letters > limitNodes) {
+        return -1;
+    }
+
+    size_t missing = missingNodes(budget->root, word);
+
+    long evicted = 0;
+    while (budget->nodesCount + missing > limitNodes) {
+        size_t keep = lowNodes > 1 + missing ? lowNodes - missing : 1;
+        evicted += evictNodes(budget, word, budget->nodesCount - keep);
+        missing = missingNodes(budget->root, word);
+    }
+    return evicted;
+}
+
+/**
+ * @brief Puts a Trie under a budget, evicting words right away if it is already over it.
+ *
+ * @param[in] root The root of the Trie, which may already hold words.
+ * @param[in] limit The maximum number of bytes the Nodes of the Trie may hold.
+ *
+ * @return The newly created budget.
+ */
+
+TrieBudget *initTrieBudget(Node *root, size_t limit) {
+    TrieBudget *budget = malloc(sizeof(TrieBudget));
+    budget->root = root;
+    budget->limit = limit > sizeof(Node) ? limit : sizeof(Node);
+    budget->nodesCount = countNodes(root);
+    budget->evictedCount = 0;
+    budget->evictions = 0;
+    makeRoom(budget, "");
+    return budget;
+}
+
+/**
+ * @brief Inserts a word into the Trie with a weight, evicting the lowest weight words first if
+ * the Nodes of the word would take the Trie over its budget.
+ *
+ * @param[in] budget The budget.
+ * @param[in] word The word to be inserted.
+ * @param[in] weight The weight to be added to the word.
+ *
+ * @return The number of words that were evicted, or -1 if the word does not fit in the budget.
+ */
+
+long budgetInsert(TrieBudget *budget, const char *word, unsigned int weight) {
+    long evicted = makeRoom(budget, word);
+    if (evicted == -1) {
+        return -1;
+    }
+    budget->nodesCount += insertWeighted(budget->root, word, weight);
+    return evicted;
+}
+
+/**
+ * @brief Returns the number of bytes held by the Nodes of the Trie.
+ *
+ * @param[in] budget The budget.
+ */
+
+size_t budgetMemory(TrieBudget *budget) {
+    return budget->nodesCount * sizeof(Node);
+}
+
+/**
+ * @brief Reclaims the memory held by the budget. The Trie is not deleted.
+ *
+ * @param[in] budget The budget.
+ */
+
+void delTrieBudget(TrieBudget *budget) {
+    free(budget);
+}
+
+/**
+ * @brief A function to test the memory budgeted Trie and all supported operations on it.
+ */
+
+void testTrieBudget() {
+    char *words[5] = {"car", "cart", "dog", "doge", "zebra"};
+    unsigned int weights[5] = {9, 9, 1, 1, 2};
+    Node *root = initTrie();
+    TrieBudget *budget = initTrieBudget(root, 16 * sizeof(Node));
+    for (int i = 0; i < 5; i++) {
+        assert(budgetInsert(budget, words[i], weights[i]) == 0);
+    }
+    assert(budgetInsert(budget, "cat", 9) == 0);
+    assert(budget->nodesCount == 15 && budgetMemory(budget) == 15 * sizeof(Node));
+    printf("inserted within the budget\n");
+
+    assert(budgetInsert(budget, "cow", 3) == 3);
+    assert(budget->nodesCount == 8 && countNodes(root) == 8);
+    assert(missingNodes(root, "dog") == 3 && missingNodes(root, "zebra") == 5);
+    assert(missingNodes(root, "cart") == 0 && missingNodes(root, "cow") == 0);
+    printf("evicted the lowest weight words and their branches\n");
+
+    assert(budgetInsert(budget, "supercalifragilistic", 9) == -1);
+    assert(budget->nodesCount == 8 && budget->evictedCount == 3);
+    printf("refused a word that can never fit\n");
+    delTrieBudget(budget);
+
+    budget = initTrieBudget(root, 7 * sizeof(Node));
+    assert(budget->nodesCount == 5 && countNodes(root) == 5);
+    assert(missingNodes(root, "cow") == 2 && missingNodes(root, "cart") == 1);
+    assert(missingNodes(root, "car") == 0 && missingNodes(root, "cat") == 0);
+    printf("cut an existing Trie down to a smaller budget, longest words first\n");
+
+    budgetInsert(budget, "ox", 1);
+    budget->limit = 4 * sizeof(Node);
+    assert(budgetInsert(budget, "ox", 1) == 2);
+    assert(countNodes(root) == 3 && root->children['o' - 'a']->children['x' - 'a']->weight == 2);
+    printf("kept the weight of the inserted word while evicting the others\n");
+
+    delTrieBudget(budget);
+    delTrie(root);
+}
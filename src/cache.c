@@ -0,0 +1,407 @@
+/**
+ * @file cache.c
+ * @author Arjun Pathak
+ * @brief This file contains the implementation of the prefix result cache.
+ *
+ * This file contains the implementations of the functions declared in the cache.h header file.
+ * Every entry is linked into three structures at once: the query hash table used for lookups, the
+ * matched prefix hash table used for invalidation and the LRU list used for eviction. The results
+ * of predictN() for a query only depend on the subtree below the node its matched prefix ends at,
+ * so an insert has to drop exactly the entries whose matched prefix is a prefix of the new word.
+ * Those are found by hashing every prefix of the inserted word.
+ */
+
+#include <string.h>
+#include <assert.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "cache.h"
+
+#define MIN_BUCKETS 64
+#define MAX_BUCKETS (1 << 20)
+#define BYTES_PER_BUCKET 512
+
+/**
+ * @brief A helper function that hashes the first length characters of a string with FNV-1a.
+ *
+ * @param[in] key The string to be hashed.
+ * @param[in] length The number of characters to hash.
+ * @param[in] salt An extra value mixed into the hash, the results length for lookups.
+ */
+
+static size_t hash(const char *key, int length, int salt) {
+    size_t value = 14695981039346656037ULL;
+    for (int i = 0; i < length; i++) {
+        value = (value ^ (unsigned char)key[i]) * 1099511628211ULL;
+    }
+    return (value ^ (size_t)salt) * 1099511628211ULL;
+}
+
+/**
+ * @brief Creates an empty cache.
+ *
+ * The number of buckets is picked from the budget, so that a full cache has chains that are a
+ * couple of entries long at most.
+ *
+ * @param[in] budget The maximum number of bytes the cached results may hold.
+ *
+ * @return The newly created cache.
+ */
+
+ResultCache *initResultCache(size_t budget) {
+    ResultCache *cache = calloc(1, sizeof(ResultCache));
+    cache->budget = budget;
+    cache->bucketsCount = MIN_BUCKETS;
+    while (cache->bucketsCount < MAX_BUCKETS && cache->bucketsCount * BYTES_PER_BUCKET < budget) {
+        cache->bucketsCount *= 2;
+    }
+    cache->byQuery = calloc(cache->bucketsCount, sizeof(CacheEntry *));
+    cache->byMatched = calloc(cache->bucketsCount, sizeof(CacheEntry *));
+    return cache;
+}
+
+static char **copyResults(char **results, int resultsLength) {
+    char **copy = calloc(resultsLength, sizeof(char *));
+    for (int i = 0; i < resultsLength && results[i]; i++) {
+        copy[i] = malloc(strlen(results[i]) + 1);
+        strcpy(copy[i], results[i]);
+    }
+    return copy;
+}
+
+/**
+ * @brief A helper function that moves an entry out of the LRU list.
+ */
+
+static void unlinkEntry(ResultCache *cache, CacheEntry *entry) {
+    if (entry->prev) {
+        entry->prev->next = entry->next;
+    } else {
+        cache->head = entry->next;
+    }
+    if (entry->next) {
+        entry->next->prev = entry->prev;
+    } else {
+        cache->tail = entry->prev;
+    }
+}
+
+/**
+ * @brief A helper function that puts an entry at the most recently used end of the LRU list.
+ */
+
+static void pushFront(ResultCache *cache, CacheEntry *entry) {
+    entry->prev = NULL;
+    entry->next = cache->head;
+    if (cache->head) {
+        cache->head->prev = entry;
+    } else {
+        cache->tail = entry;
+    }
+    cache->head = entry;
+}
+
+/**
+ * @brief A helper function that unlinks an entry from all three structures and frees it.
+ *
+ * @param[in] cache The cache.
+ * @param[in] entry The entry to be removed.
+ */
+
+static void removeEntry(ResultCache *cache, CacheEntry *entry) {
+    size_t mask = cache->bucketsCount - 1;
+    CacheEntry **link = &cache->byQuery[hash(entry->query, strlen(entry->query),
+                                             entry->resultsLength) & mask];
+    while (*link != entry) {
+        link = &(*link)->queryNext;
+    }
+    *link = entry->queryNext;
+
+    link = &cache->byMatched[hash(entry->query, entry->matchedLength, 0) & mask];
+    while (*link != entry) {
+        link = &(*link)->matchedNext;
+    }
+    *link = entry->matchedNext;
+
+    unlinkEntry(cache, entry);
+    cache->bytes -= entry->bytes;
+    cache->entriesCount--;
+
+    for (int i = 0; i < entry->resultsLength; i++) {
+        free(entry->results[i]);
+    }
+    free(entry->results);
+    free(entry->query);
+    free(entry);
+}
+
+/**
+ * @brief A helper function that returns the length of the part of the word found in the Trie.
+ */
+
+static int matchedLength(Node *root, string *word) {
+    Node *itr = root;
+    int count = 0;
+    while (count < word->length && itr->children[word->array[count] - 'a']) {
+        itr = itr->children[word->array[count] - 'a'];
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief Returns the first N matching words, from the cache if possible and from predictN() if not.
+ *
+ * On a hit the entry is moved to the front of the LRU list and a copy of its results is returned.
+ * On a miss predictN() is called, and a copy of its results is stored. Entries are then evicted
+ * from the back of the list until the cache is within its budget again. Results that would not fit
+ * in the budget on their own are not cached at all.
+ *
+ * @param[in] cache The cache.
+ * @param[in] root The root of the Trie the cache belongs to.
+ * @param[in] word The word to be prefix matched.
+ * @param[in] results The number of results to be returned.
+ *
+ * @return A buffer of results entries that the caller owns.
+ */
+
+char **cachedPredictN(ResultCache *cache, Node *root, string *word, int results) {
+    sanitize(word);
+    size_t mask = cache->bucketsCount - 1;
+    size_t bucket = hash(word->array, word->length, results) & mask;
+    for (CacheEntry *entry = cache->byQuery[bucket]; entry; entry = entry->queryNext) {
+        if (entry->resultsLength == results && strcmp(entry->query, word->array) == 0) {
+            cache->hits++;
+            unlinkEntry(cache, entry);
+            pushFront(cache, entry);
+            return copyResults(entry->results, results);
+        }
+    }
+    cache->misses++;
+
+    char **resultsBuffer = cache->ranked ? predictRanked(root, word, results)
+                                         : predictN(root, word, results);
+    size_t bytes = sizeof(CacheEntry) + word->length + 1 + sizeof(char *) * results;
+    for (int i = 0; i < results && resultsBuffer[i]; i++) {
+        bytes += strlen(resultsBuffer[i]) + 1;
+    }
+    if (bytes > cache->budget) {
+        return resultsBuffer;
+    }
+
+    CacheEntry *entry = malloc(sizeof(CacheEntry));
+    entry->query = malloc(word->length + 1);
+    strcpy(entry->query, word->array);
+    entry->matchedLength = matchedLength(root, word);
+    entry->resultsLength = results;
+    entry->results = copyResults(resultsBuffer, results);
+    entry->bytes = bytes;
+
+    entry->queryNext = cache->byQuery[bucket];
+    cache->byQuery[bucket] = entry;
+    size_t matchedBucket = hash(entry->query, entry->matchedLength, 0) & mask;
+    entry->matchedNext = cache->byMatched[matchedBucket];
+    cache->byMatched[matchedBucket] = entry;
+    pushFront(cache, entry);
+    cache->bytes += bytes;
+    cache->entriesCount++;
+
+    while (cache->bytes > cache->budget) {
+        removeEntry(cache, cache->tail);
+        cache->evictions++;
+    }
+
+    return resultsBuffer;
+}
+
+/**
+ * @brief Drops the cached results that inserting a word into the Trie could change.
+ *
+ * The word is read the way insertWeighted() reads it, lowercased up to its first character that is
+ * not a letter, since that is the word the Trie ends up holding. Inserting a word that is already
+ * in the Trie changes nothing unless the cache is ranked, so the cache is left alone in that case.
+ * Otherwise the matched prefix table is probed with every prefix of the word, including the empty
+ * one, and the entries whose matched prefix is equal to it are removed.
+ *
+ * @param[in] cache The cache.
+ * @param[in] root The root of the Trie the cache belongs to.
+ * @param[in] word The word that is about to be inserted.
+ *
+ * @return false if the word is already in the Trie and the cache is not ranked.
+ */
+
+bool invalidateWord(ResultCache *cache, Node *root, const char *word) {
+    int length = 0;
+    while ((word[length] >= 'a' && word[length] <= 'z')
+           || (word[length] >= 'A' && word[length] <= 'Z')) {
+        length++;
+    }
+    char *lowered = malloc(length + 1);
+    Node *itr = root;
+    for (int i = 0; i < length; i++) {
+        lowered[i] = tolower((unsigned char)word[i]);
+        itr = itr ? itr->children[lowered[i] - 'a'] : NULL;
+    }
+    lowered[length] = '\0';
+    if (itr && itr->isEndOfWord && !cache->ranked) {
+        free(lowered);
+        return false;
+    }
+
+    size_t mask = cache->bucketsCount - 1;
+    for (int i = 0; i <= length; i++) {
+        CacheEntry *entry = cache->byMatched[hash(lowered, i, 0) & mask];
+        while (entry) {
+            CacheEntry *next = entry->matchedNext;
+            if (entry->matchedLength == i && strncmp(entry->query, lowered, i) == 0) {
+                removeEntry(cache, entry);
+                cache->invalidations++;
+            }
+            entry = next;
+        }
+    }
+    free(lowered);
+    return true;
+}
+
+/**
+ * @brief Inserts a word into the Trie and drops the cached results that it could change.
+ *
+ * @param[in] cache The cache.
+ * @param[in] root The root of the Trie the cache belongs to.
+ * @param[in] word The word to be inserted.
+ */
+
+void cachedInsert(ResultCache *cache, Node *root, const char *word) {
+    if (invalidateWord(cache, root, word)) {
+        insert(root, word);
+    }
+}
+
+/**
+ * @brief Drops every cached result, for changes to the Trie that can affect any query, like words
+ * being evicted from it.
+ *
+ * @param[in] cache The cache.
+ */
+
+void clearResultCache(ResultCache *cache) {
+    while (cache->head) {
+        removeEntry(cache, cache->head);
+        cache->invalidations++;
+    }
+}
+
+/**
+ * @brief Prints the hit, miss, eviction and invalidation counts of the cache.
+ *
+ * @param[in] cache The cache.
+ */
+
+void printCacheStats(ResultCache *cache) {
+    size_t lookups = cache->hits + cache->misses;
+    printf("Cache: %zu hits, %zu misses (%.1f%% hit rate), %zu evictions, %zu invalidations\n",
+           cache->hits, cache->misses, lookups ? 100.0 * cache->hits / lookups : 0.0,
+           cache->evictions, cache->invalidations);
+    printf("Cache: %zu entries using %zu of %zu bytes\n", cache->entriesCount, cache->bytes,
+           cache->budget);
+}
+
+/**
+ * @brief Drops all the entries and deletes the cache.
+ *
+ * @param[in] cache The cache.
+ */
+
+void delResultCache(ResultCache *cache) {
+    while (cache->head) {
+        removeEntry(cache, cache->head);
+    }
+    free(cache->byQuery);
+    free(cache->byMatched);
+    free(cache);
+}
+
+/**
+ * @brief A function to test the cache and all supported operations on it.
+ */
+
+void testResultCache() {
+    Node *root = initTrie();
+    insert(root, "telephone");
+    insert(root, "teleport");
+    ResultCache *cache = initResultCache(4096);
+
+    char *tests[3] = {"tele", "TELE", "tel"};
+    for (int i = 0; i < 3; i++) {
+        string *query = initString(tests[i], strlen(tests[i]));
+        char **buffer = cachedPredictN(cache, root, query, 3);
+        assert(strcmp(buffer[0], "teleport") == 0);
+        assert(strcmp(buffer[1], "telephone") == 0);
+        assert(buffer[2] == NULL);
+        for (int j = 0; j < 3; j++) {
+            free(buffer[j]);
+        }
+        free(buffer);
+        delString(query);
+    }
+    assert(cache->hits == 1 && cache->misses == 2 && cache->entriesCount == 2);
+    printf("cache hit on the sanitized query\n");
+
+    cachedInsert(cache, root, "teleport");
+    assert(cache->invalidations == 0);
+    cachedInsert(cache, root, "TELEport");
+    assert(cache->invalidations == 0);
+    cachedInsert(cache, root, "Telex");
+    assert(cache->invalidations == 2 && cache->entriesCount == 0);
+    printf("insert dropped the entries it changes\n");
+
+    string *query = initString("telex", 5);
+    char **buffer = cachedPredictN(cache, root, query, 1);
+    assert(strcmp(buffer[0], "telex") == 0);
+    free(buffer[0]);
+    free(buffer);
+    delString(query);
+
+    cachedInsert(cache, root, "abc");
+    assert(cache->entriesCount == 1);
+    printf("insert in another subtree kept the entries\n");
+
+    delResultCache(cache);
+    cache = initResultCache(sizeof(CacheEntry) + 64);
+    for (int i = 0; i < 3; i++) {
+        string *query = initString(tests[i], strlen(tests[i]));
+        char **buffer = cachedPredictN(cache, root, query, 1);
+        free(buffer[0]);
+        free(buffer);
+        delString(query);
+    }
+    assert(cache->entriesCount == 1 && cache->evictions == 1);
+    assert(cache->bytes <= cache->budget);
+    printf("evicted down to the budget\n");
+
+    clearResultCache(cache);
+    assert(cache->entriesCount == 0 && cache->bytes == 0);
+    printf("cleared the cache\n");
+
+    cache->ranked = true;
+    size_t misses = cache->misses;
+    char *ranked[2] = {"telex", "teleport"};
+    for (int i = 0; i < 2; i++) {
+        string *query = initString("tele", 4);
+        char **buffer = cachedPredictN(cache, root, query, 1);
+        assert(strcmp(buffer[0], ranked[i]) == 0);
+        free(buffer[0]);
+        free(buffer);
+        delString(query);
+        cachedInsert(cache, root, "teleport");
+    }
+    assert(cache->misses == misses + 2);
+    printf("insert of a known word dropped the ranked entries it reorders\n");
+
+    delResultCache(cache);
+    delTrie(root);
+}
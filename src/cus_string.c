@@ -37,6 +37,8 @@ string *initString(char* array, int length) {
     strcpy(str->array, array);
     str->capacity = length+1;
     str->length = length;
+
+    return str;
 }
 
 /**
@@ -52,7 +54,7 @@ string *initString(char* array, int length) {
  */
 
 static void resize(string *input) {
-    int newCapacity = input->length*2 + 1;
+    int newCapacity = input->capacity * 2;
     input->array = (char *) realloc(input->array, newCapacity * sizeof(char)); 
     input->capacity = newCapacity;
 }
@@ -0,0 +1,388 @@
+/**
+ * @file darray.c
+ * @author Arjun Pathak
+ * @brief This file contains the double-array Trie implementation.
+ *
+ * This file contains the implementations of the functions declared in the darray.h header file.
+ * The words are sorted and deduplicated first, so the words that share a prefix of length d form
+ * a consecutive range. The Trie is then built top down: for every state the distinct letters at
+ * the current depth of its range are gathered and the smallest BASE for which all the needed slots
+ * are free is chosen. Letters are coded 1 to 26, so that a BASE of 0 is a valid choice.
+ */
+
+#include <string.h>
+#include <strings.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "darray.h"
+#include "trie.h"
+
+/**
+ * @struct Key
+ * @brief A word from the input list along with the length of the part that is stored.
+ */
+
+struct Key {
+    const char *word;
+    int length;
+};
+typedef struct Key Key;
+
+/**
+ * @struct Builder
+ * @brief The state that is carried through the construction of the arrays.
+ *
+ * @var Builder::nextCheckPos
+ * Member nextCheckPos is the position from which the search for a free BASE starts. Everything
+ * before it is known to be almost fully used.
+ */
+
+struct Builder {
+    DoubleArray *da;
+    Key *keys;
+    int nextCheckPos;
+};
+typedef struct Builder Builder;
+
+static int compareKeys(const void *a, const void *b) {
+    const Key *keyA = a, *keyB = b;
+    int length = keyA->length < keyB->length ? keyA->length : keyB->length;
+    int cmp = strncasecmp(keyA->word, keyB->word, length);
+    if (cmp != 0) {
+        return cmp;
+    }
+    return keyA->length - keyB->length;
+}
+
+/**
+ * @brief A helper function that grows the arrays until the given slot exists.
+ *
+ * @param[in, out] da The Trie being built.
+ * @param[in] slot The slot that has to be addressable.
+ */
+
+static void ensureSize(DoubleArray *da, int slot) {
+    if (slot < da->size) {
+        return;
+    }
+    int newSize = da->size;
+    while (newSize <= slot) {
+        newSize *= 2;
+    }
+    da->base = realloc(da->base, sizeof(int) * newSize);
+    da->check = realloc(da->check, sizeof(int) * newSize);
+    da->terminal = realloc(da->terminal, newSize);
+    for (int i = da->size; i < newSize; i++) {
+        da->base[i] = 0;
+        da->check[i] = -1;
+        da->terminal[i] = 0;
+    }
+    da->size = newSize;
+}
+
+/**
+ * @brief A helper function that finds a BASE for which all the given codes land on free slots.
+ *
+ * The candidate slots for the first code are scanned from nextCheckPos onwards. The start of the
+ * scan is moved forward past regions that turned out to be more than 95% full, which keeps the
+ * search close to linear over the whole build.
+ *
+ * @param[in, out] builder The state of the build.
+ * @param[in] codes The sorted letter codes of the children.
+ * @param[in] codesCount The number of children.
+ *
+ * @return The chosen BASE.
+ */
+
+static int findBase(Builder *builder, int *codes, int codesCount) {
+    DoubleArray *da = builder->da;
+    int position = (codes[0] > builder->nextCheckPos ? codes[0] : builder->nextCheckPos) - 1;
+    int used = 0;
+    bool firstFree = true;
+    int base;
+
+    while (true) {
+        position++;
+        ensureSize(da, position + 27);
+        if (da->check[position] != -1) {
+            used++;
+            continue;
+        }
+        if (firstFree) {
+            builder->nextCheckPos = position;
+            firstFree = false;
+        }
+        base = position - codes[0];
+        bool fits = true;
+        for (int i = 1; i < codesCount; i++) {
+            if (da->check[base + codes[i]] != -1) {
+                fits = false;
+                break;
+            }
+        }
+        if (fits) {
+            break;
+        }
+    }
+
+    if (used * 20 >= (position - builder->nextCheckPos + 1) * 19) {
+        builder->nextCheckPos = position;
+    }
+    return base;
+}
+
+/**
+ * @brief A helper function that lays out a state and, recursively, everything below it.
+ *
+ * @param[in, out] builder The state of the build.
+ * @param[in] state The slot of the state being laid out.
+ * @param[in] low The first key of the range that shares the path to this state.
+ * @param[in] high One past the last key of that range.
+ * @param[in] depth The length of the path to this state.
+ */
+
+static void buildState(Builder *builder, int state, int low, int high, int depth) {
+    DoubleArray *da = builder->da;
+    Key *keys = builder->keys;
+    if (low < high && keys[low].length == depth) {
+        da->terminal[state] = 1;
+        low++;
+    }
+    if (low == high) {
+        return;
+    }
+
+    int codes[26], starts[27], codesCount = 0;
+    for (int i = low; i < high; i++) {
+        int code = (keys[i].word[depth] | 0x20) - 'a' + 1;
+        if (codesCount == 0 || codes[codesCount - 1] != code) {
+            codes[codesCount] = code;
+            starts[codesCount++] = i;
+        }
+    }
+    starts[codesCount] = high;
+
+    int base = findBase(builder, codes, codesCount);
+    da->base[state] = base;
+    for (int i = 0; i < codesCount; i++) {
+        da->check[base + codes[i]] = state;
+        if (base + codes[i] >= da->statesCount) {
+            da->statesCount = base + codes[i] + 1;
+        }
+    }
+    for (int i = 0; i < codesCount; i++) {
+        buildState(builder, base + codes[i], starts[i], starts[i + 1], depth + 1);
+    }
+}
+
+/**
+ * @brief Builds a double-array Trie out of a list of words.
+ *
+ * The words are turned into keys, sorted and deduplicated, after which buildState() lays out the
+ * states starting from the root. The arrays are trimmed down to the used size at the end.
+ *
+ * @param[in] words The words to be stored.
+ * @param[in] wordsCount The number of words.
+ *
+ * @return The newly built Trie.
+ */
+
+DoubleArray *initDoubleArray(char **words, int wordsCount) {
+    Key *keys = malloc(sizeof(Key) * (wordsCount + 1));
+    for (int i = 0; i < wordsCount; i++) {
+        keys[i].word = words[i];
+        keys[i].length = 0;
+        char c = words[i][keys[i].length];
+        while ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+            c = words[i][++keys[i].length];
+        }
+    }
+    qsort(keys, wordsCount, sizeof(Key), compareKeys);
+    int keysCount = 0;
+    for (int i = 0; i < wordsCount; i++) {
+        if (keysCount == 0 || compareKeys(&keys[keysCount - 1], &keys[i]) != 0) {
+            keys[keysCount++] = keys[i];
+        }
+    }
+
+    DoubleArray *da = malloc(sizeof(DoubleArray));
+    da->size = 1024;
+    da->base = calloc(da->size, sizeof(int));
+    da->check = malloc(sizeof(int) * da->size);
+    da->terminal = calloc(da->size, 1);
+    for (int i = 0; i < da->size; i++) {
+        da->check[i] = -1;
+    }
+    da->check[0] = 0;
+    da->statesCount = 1;
+
+    Builder builder = {da, keys, 1};
+    buildState(&builder, 0, 0, keysCount, 0);
+    free(keys);
+
+    if (da->statesCount + 27 < da->size) {
+        da->size = da->statesCount + 27;
+        da->base = realloc(da->base, sizeof(int) * da->size);
+        da->check = realloc(da->check, sizeof(int) * da->size);
+        da->terminal = realloc(da->terminal, da->size);
+    }
+
+    return da;
+}
+
+/**
+ * @brief A helper function that follows a transition.
+ *
+ * @return The next state, or -1 if the state has no child on the given letter index.
+ */
+
+static int transition(DoubleArray *da, int state, int index) {
+    int next = da->base[state] + index + 1;
+    return da->check[next] == state ? next : -1;
+}
+
+/**
+ * @brief A helper function that spells out the word that ends at a state.
+ *
+ * The letter on the edge into a state t is t - BASE[CHECK[t]], so the word is read by walking the
+ * CHECK array up to the starting state.
+ *
+ * @param[in] da The double-array Trie.
+ * @param[in] state The state the word ends at.
+ * @param[in] start The state the BFS started from.
+ * @param[in] prefix The matched prefix, which spells out the path down to the starting state.
+ */
+
+static char *spell(DoubleArray *da, int state, int start, string *prefix) {
+    int depth = 0;
+    for (int s = state; s != start; s = da->check[s]) {
+        depth++;
+    }
+    char *match = malloc(prefix->length + depth + 1);
+    memcpy(match, prefix->array, prefix->length);
+    match[prefix->length + depth] = '\0';
+    for (int i = prefix->length + depth - 1; i >= prefix->length; i--) {
+        int parent = da->check[state];
+        match[i] = 'a' + state - da->base[parent] - 1;
+        state = parent;
+    }
+    return match;
+}
+
+/**
+ * @brief Returns the first N matching words, in the same order as predictN().
+ *
+ * The prefix is walked down as far as it matches. A BFS is then done from the state reached, with
+ * the children of each state visited in alphabetical order. The queue is a flat array of state
+ * numbers, since the words can be spelled out from the states alone.
+ *
+ * @param[in] da The double-array Trie.
+ * @param[in] word The word to be prefix matched.
+ * @param[in] results The number of results to be returned.
+ *
+ * @return A buffer of results entries, unused entries are set to NULL.
+ */
+
+char **daPredictN(DoubleArray *da, string *word, int results) {
+    sanitize(word);
+    char **resultsBuffer = calloc(results, sizeof(char *));
+
+    int state = 0, count = 0;
+    for (int i = 0; i < word->length; i++) {
+        int next = transition(da, state, word->array[i] - 'a');
+        if (next == -1) {
+            break;
+        }
+        state = next;
+        count++;
+    }
+    string *prefix = duplicate(word);
+    prefix->array[count] = '\0';
+    prefix->length = count;
+
+    int capacity = 64, front = 0, back = 0;
+    int *queue = malloc(sizeof(int) * capacity);
+    queue[back++] = state;
+
+    int matches = 0;
+    while (front < back && matches != results) {
+        int current = queue[front++];
+        if (da->terminal[current]) {
+            resultsBuffer[matches++] = spell(da, current, state, prefix);
+        }
+        for (int i = 0; i < 26; i++) {
+            int next = transition(da, current, i);
+            if (next != -1) {
+                if (back == capacity) {
+                    capacity *= 2;
+                    queue = realloc(queue, sizeof(int) * capacity);
+                }
+                queue[back++] = next;
+            }
+        }
+    }
+
+    free(queue);
+    delString(prefix);
+    return resultsBuffer;
+}
+
+/**
+ * @brief Returns the number of heap bytes that are held by the Trie.
+ *
+ * @param[in] da The double-array Trie.
+ */
+
+size_t doubleArrayMemory(DoubleArray *da) {
+    return sizeof(DoubleArray) + (size_t)da->size * (2 * sizeof(int) + 1);
+}
+
+/**
+ * @brief Reclaims all the memory held by the Trie.
+ *
+ * @param[in] da The double-array Trie.
+ */
+
+void delDoubleArray(DoubleArray *da) {
+    free(da->base);
+    free(da->check);
+    free(da->terminal);
+    free(da);
+}
+
+/**
+ * @brief A function to test the double-array Trie against the pointer Trie.
+ */
+
+void testDoubleArray() {
+    char *words[8] = {"teleport", "telephone", "telegram", "tea", "a", "zebra", "tea", "Tea"};
+    DoubleArray *da = initDoubleArray(words, 8);
+    Node *root = initTrie();
+    for (int i = 0; i < 8; i++) {
+        insert(root, words[i]);
+    }
+    printf("built the double-array trie\n");
+
+    char *tests[6] = {"tele", "t", "", "abc", "zebra", "telex"};
+    for (int i = 0; i < 6; i++) {
+        string *query = initString(tests[i], strlen(tests[i]));
+        char **expected = predictN(root, query, 4);
+        char **buffer = daPredictN(da, query, 4);
+        for (int j = 0; j < 4; j++) {
+            assert((expected[j] == NULL) == (buffer[j] == NULL));
+            assert(expected[j] == NULL || strcmp(expected[j], buffer[j]) == 0);
+            free(expected[j]);
+            free(buffer[j]);
+        }
+        free(expected);
+        free(buffer);
+        delString(query);
+    }
+    printf("double-array predictions match the trie\n");
+
+    delDoubleArray(da);
+    delTrie(root);
+}
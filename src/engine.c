@@ -0,0 +1,443 @@
+/**
+ * @file engine.c
+ * @author Arjun Pathak
+ * @brief This file contains the completion engines and the functions that drive them.
+ *
+ * This file contains the implementations of the functions declared in the engine.h header file,
+ * along with one table of operations per search structure. The operations are thin wrappers that
+ * adapt the functions of each structure to the common signatures; the structures themselves are
+ * not changed. The file ends with a differential test that runs the same queries through every
+ * engine and checks the results against predictN() on the pointer Trie.
+ */
+
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "darray.h"
+#include "engine.h"
+#include "louds.h"
+
+/**
+ * @brief A helper function that counts the words and the nodes below a Trie Node.
+ *
+ * @param[in] node The Trie Node to start from.
+ * @param[in, out] words The number of nodes that end a word.
+ * @param[in, out] nodes The number of nodes.
+ */
+
+static void countTrie(Node *node, size_t *words, size_t *nodes) {
+    *words += node->isEndOfWord;
+    (*nodes)++;
+    for (int i = 0; i < 26; i++) {
+        if (node->children[i]) {
+            countTrie(node->children[i], words, nodes);
+        }
+    }
+}
+
+static void *trieBuild(Node *root) {
+    return root;
+}
+
+static void trieInsert(void *structure, const char *word) {
+    insert(structure, word);
+}
+
+static char **trieComplete(void *structure, string *word, int resultsLength) {
+    return predictN(structure, word, resultsLength);
+}
+
+static void trieCompleteBatch(void *structure, string **words, int wordsCount,
+                              int resultsLength, char ***results) {
+    predictNBatch(structure, words, wordsCount, resultsLength, results);
+}
+
+static size_t trieCount(void *structure) {
+    size_t words = 0, nodes = 0;
+    countTrie(structure, &words, &nodes);
+    return words;
+}
+
+static size_t trieMemory(void *structure) {
+    size_t words = 0, nodes = 0;
+    countTrie(structure, &words, &nodes);
+    return nodes * sizeof(Node);
+}
+
+static void trieDestroy(void *structure) {
+    delTrie(structure);
+}
+
+const EngineType trieEngine = {
+    "trie", trieBuild, trieInsert, trieComplete, trieCompleteBatch, trieCount, trieMemory,
+    trieDestroy,
+};
+
+static char **rankedComplete(void *structure, string *word, int resultsLength) {
+    return predictRanked(structure, word, resultsLength);
+}
+
+const EngineType rankedEngine = {
+    "ranked", trieBuild, trieInsert, rankedComplete, NULL, trieCount, trieMemory, trieDestroy,
+};
+
+static void *loudsBuild(Node *root) {
+    Louds *louds = initLouds(root);
+    delTrie(root);
+    return louds;
+}
+
+static char **loudsComplete(void *structure, string *word, int resultsLength) {
+    return loudsPredictN(structure, word, resultsLength);
+}
+
+static size_t loudsCount(void *structure) {
+    Louds *louds = structure;
+    size_t words = 0;
+    for (size_t i = 0; i < (louds->nodesCount + 63) / 64; i++) {
+        words += __builtin_popcountll(louds->terminals[i]);
+    }
+    return words;
+}
+
+static size_t loudsBytes(void *structure) {
+    return loudsMemory(structure);
+}
+
+static void loudsDestroy(void *structure) {
+    delLouds(structure);
+}
+
+static const EngineType loudsEngine = {
+    "louds", loudsBuild, NULL, loudsComplete, NULL, loudsCount, loudsBytes, loudsDestroy,
+};
+
+/**
+ * @brief A helper function that collects the words of the Trie in alphabetical order.
+ *
+ * The path from the root to the current node is kept in a single string, the same way the suffix
+ * index collects its words.
+ *
+ * @param[in] current The Trie Node being visited.
+ * @param[in, out] path The letters on the path from the root to current.
+ * @param[in, out] words The words collected so far.
+ * @param[in, out] wordsCount The number of words collected so far.
+ * @param[in, out] capacity The current capacity of the words array.
+ */
+
+static void collectWords(Node *current, string *path, char ***words, int *wordsCount,
+                         int *capacity) {
+    if (current->isEndOfWord) {
+        if (*wordsCount == *capacity) {
+            *capacity *= 2;
+            *words = realloc(*words, sizeof(char *) * *capacity);
+        }
+        (*words)[*wordsCount] = malloc(path->length + 1);
+        memcpy((*words)[(*wordsCount)++], path->array, path->length + 1);
+    }
+    for (int i = 0; i < 26; i++) {
+        if (current->children[i]) {
+            append(path, 'a' + i);
+            collectWords(current->children[i], path, words, wordsCount, capacity);
+            path->array[--path->length] = '\0';
+        }
+    }
+}
+
+static void *doubleArrayBuild(Node *root) {
+    int wordsCount = 0, capacity = 1024;
+    char **words = malloc(sizeof(char *) * capacity);
+    string *path = initString("", 0);
+    collectWords(root, path, &words, &wordsCount, &capacity);
+    delString(path);
+    delTrie(root);
+
+    DoubleArray *da = initDoubleArray(words, wordsCount);
+    for (int i = 0; i < wordsCount; i++) {
+        free(words[i]);
+    }
+    free(words);
+    return da;
+}
+
+static char **doubleArrayComplete(void *structure, string *word, int resultsLength) {
+    return daPredictN(structure, word, resultsLength);
+}
+
+static size_t doubleArrayCount(void *structure) {
+    DoubleArray *da = structure;
+    size_t words = 0;
+    for (int i = 0; i < da->size; i++) {
+        words += da->terminal[i];
+    }
+    return words;
+}
+
+static size_t doubleArrayBytes(void *structure) {
+    return doubleArrayMemory(structure);
+}
+
+static void doubleArrayDestroy(void *structure) {
+    delDoubleArray(structure);
+}
+
+static const EngineType doubleArrayEngine = {
+    "darray", doubleArrayBuild, NULL, doubleArrayComplete, NULL, doubleArrayCount,
+    doubleArrayBytes, doubleArrayDestroy,
+};
+
+const EngineType *const engineTypes[] = {
+    &trieEngine,
+    &loudsEngine,
+    &doubleArrayEngine,
+    NULL,
+};
+
+/**
+ * @brief Returns the engine type with the given name, or NULL if there is none.
+ *
+ * @param[in] name The name of the engine.
+ */
+
+const EngineType *findEngineType(const char *name) {
+    for (int i = 0; engineTypes[i]; i++) {
+        if (strcmp(engineTypes[i]->name, name) == 0) {
+            return engineTypes[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Builds an engine out of a populated Trie.
+ *
+ * @param[in] type The kind of engine to build.
+ * @param[in] root The root of a populated Trie. The engine takes ownership of the Trie, the
+ * caller must not use it again unless engineTrie() hands it back.
+ *
+ * @return The newly built engine.
+ */
+
+Engine *initEngine(const EngineType *type, Node *root) {
+    Engine *engine = malloc(sizeof(Engine));
+    engine->type = type;
+    engine->structure = type->build(root);
+    return engine;
+}
+
+/**
+ * @brief Adds a word to the engine.
+ *
+ * @param[in] engine The engine.
+ * @param[in] word The word to be inserted.
+ *
+ * @return false if the engine is read-only.
+ */
+
+bool engineInsert(Engine *engine, const char *word) {
+    if (engine->type->insert == NULL) {
+        return false;
+    }
+    engine->type->insert(engine->structure, word);
+    return true;
+}
+
+/**
+ * @brief Returns the first N completions of a query, in the same order as predictN().
+ *
+ * @param[in] engine The engine.
+ * @param[in] word The query. It is sanitized in place.
+ * @param[in] resultsLength The number of results to be returned.
+ *
+ * @return A buffer of resultsLength entries, unused entries are set to NULL.
+ */
+
+char **engineComplete(Engine *engine, string *word, int resultsLength) {
+    return engine->type->complete(engine->structure, word, resultsLength);
+}
+
+/**
+ * @brief Returns the first N completions of many queries, the same ones engineComplete() returns.
+ *
+ * Engines without a batched path answer the queries one by one.
+ *
+ * @param[in] engine The engine.
+ * @param[in] words The queries. Each one is sanitized in place.
+ * @param[in] wordsCount The number of queries.
+ * @param[in] resultsLength The number of results to be returned per query.
+ * @param[out] results Receives one buffer of resultsLength entries per query.
+ */
+
+void engineCompleteBatch(Engine *engine, string **words, int wordsCount, int resultsLength,
+                         char ***results) {
+    if (engine->type->completeBatch) {
+        engine->type->completeBatch(engine->structure, words, wordsCount, resultsLength, results);
+        return;
+    }
+    for (int i = 0; i < wordsCount; i++) {
+        results[i] = engine->type->complete(engine->structure, words[i], resultsLength);
+    }
+}
+
+/**
+ * @brief Returns the number of words held by the engine.
+ *
+ * @param[in] engine The engine.
+ */
+
+size_t engineCount(Engine *engine) {
+    return engine->type->count(engine->structure);
+}
+
+/**
+ * @brief Returns the number of heap bytes held by the engine.
+ *
+ * @param[in] engine The engine.
+ */
+
+size_t engineMemory(Engine *engine) {
+    return engine->type->memory(engine->structure);
+}
+
+/**
+ * @brief Returns the pointer Trie behind the engine, or NULL if the engine does not keep one.
+ *
+ * @param[in] engine The engine.
+ */
+
+Node *engineTrie(Engine *engine) {
+    return engine->type == &trieEngine || engine->type == &rankedEngine ? engine->structure : NULL;
+}
+
+/**
+ * @brief Reclaims all the memory held by the engine, including its Trie.
+ *
+ * @param[in] engine The engine.
+ */
+
+void delEngine(Engine *engine) {
+    engine->type->destroy(engine->structure);
+    free(engine);
+}
+
+/**
+ * @brief A differential test that checks every engine against predictN() on the pointer Trie.
+ *
+ * Every prefix of every word is queried, along with queries that only match part of the way, an
+ * uppercase query and the empty query, for a range of result counts. The same words are then
+ * answered as a single batch.
+ */
+
+void testEngines() {
+    int nWords = 9;
+    char *words[9] = {
+        "teleport",
+        "telephone",
+        "telegram",
+        "tea",
+        "team",
+        "tea",
+        "Phone",
+        "zebra",
+        "don't",
+    };
+    int nExtra = 5;
+    char *extra[5] = {"", "telex", "TELE", "x", "zebras"};
+
+    Node *reference = initTrie();
+    for (int i = 0; i < nWords; i++) {
+        insert(reference, words[i]);
+    }
+
+    for (int e = 0; engineTypes[e]; e++) {
+        Node *root = initTrie();
+        for (int i = 0; i < nWords; i++) {
+            insert(root, words[i]);
+        }
+        Engine *engine = initEngine(engineTypes[e], root);
+        assert(engineCount(engine) == 8);
+        assert(engineMemory(engine) > 0);
+        assert((engineTrie(engine) != NULL) == (engineTypes[e] == &trieEngine));
+
+        int queries = 0;
+        for (int i = 0; i < nWords + nExtra; i++) {
+            const char *word = i < nWords ? words[i] : extra[i - nWords];
+            for (int length = 0; length <= (int)strlen(word); length++) {
+                for (int results = 1; results <= 6; results++) {
+                    char prefix[16] = {0};
+                    memcpy(prefix, word, length);
+                    string *query = initString(prefix, length);
+                    string *copy = duplicate(query);
+                    char **expected = predictN(reference, query, results);
+                    char **buffer = engineComplete(engine, copy, results);
+                    for (int j = 0; j < results; j++) {
+                        assert((expected[j] == NULL) == (buffer[j] == NULL));
+                        assert(expected[j] == NULL || strcmp(expected[j], buffer[j]) == 0);
+                        free(expected[j]);
+                        free(buffer[j]);
+                    }
+                    free(expected);
+                    free(buffer);
+                    delString(query);
+                    delString(copy);
+                    queries++;
+                }
+            }
+        }
+        printf("%s engine matched the reference on %d queries\n", engineTypes[e]->name, queries);
+
+        string *batch[14];
+        char **batchResults[14];
+        for (int i = 0; i < nWords + nExtra; i++) {
+            const char *word = i < nWords ? words[i] : extra[i - nWords];
+            batch[i] = initString((char *)word, strlen(word));
+        }
+        engineCompleteBatch(engine, batch, nWords + nExtra, 3, batchResults);
+        for (int i = 0; i < nWords + nExtra; i++) {
+            char **expected = predictN(reference, batch[i], 3);
+            for (int j = 0; j < 3; j++) {
+                assert((expected[j] == NULL) == (batchResults[i][j] == NULL));
+                assert(expected[j] == NULL || strcmp(expected[j], batchResults[i][j]) == 0);
+                free(expected[j]);
+                free(batchResults[i][j]);
+            }
+            free(expected);
+            free(batchResults[i]);
+            delString(batch[i]);
+        }
+        printf("%s engine matched the reference on a batch\n", engineTypes[e]->name);
+
+        if (engineInsert(engine, "telex")) {
+            string *query = initString("telex", 5);
+            char **buffer = engineComplete(engine, query, 1);
+            assert(strcmp(buffer[0], "telex") == 0);
+            free(buffer[0]);
+            free(buffer);
+            delString(query);
+            assert(engineCount(engine) == 9);
+            printf("%s engine took an insert\n", engineTypes[e]->name);
+        }
+        delEngine(engine);
+    }
+    assert(findEngineType("louds") != NULL && findEngineType("btree") == NULL);
+
+    Node *root = initTrie();
+    for (int i = 0; i < nWords; i++) {
+        insert(root, words[i]);
+    }
+    Engine *engine = initEngine(&rankedEngine, root);
+    assert(engineTrie(engine) == root && engineCount(engine) == 8);
+    string *query = initString("t", 1);
+    char **buffer = engineComplete(engine, query, 2);
+    assert(strcmp(buffer[0], "tea") == 0 && strcmp(buffer[1], "team") == 0);
+    free(buffer[0]);
+    free(buffer[1]);
+    free(buffer);
+    delString(query);
+    printf("ranked engine put the word inserted twice first\n");
+    delEngine(engine);
+    delTrie(reference);
+}
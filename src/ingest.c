@@ -0,0 +1,402 @@
+/**
+ * @file ingest.c
+ * @author Arjun Pathak
+ * @brief This file contains the implementation of the ingest mode.
+ *
+ * This file contains the implementations of the functions declared in the ingest.h header file.
+ * There is no dedicated reader thread: every thread takes the input lock, reads the next chunk
+ * and cuts it after its last complete token, leaving the unfinished token at the end behind for
+ * the next chunk, and then tokenizes its chunk outside the lock. Reading a chunk is much cheaper
+ * than tokenizing it, so the threads rarely wait on each other. Each thread counts into an open
+ * addressing hash table of its own, whose words are interned in a word pool, so counting takes no
+ * lock and no allocation per token. Once the whole input is read, the counts of every thread are
+ * folded into the table of the first one, and every word is then added into the Trie once with
+ * its total, through its budget if it has one. Adding the counts thread by thread instead would
+ * let the budget evict a word between two threads, after which it would come back with only the
+ * count of the later threads.
+ */
+
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "ingest.h"
+#include "pool.h"
+
+#ifndef INGEST_CHUNK_SIZE
+#define INGEST_CHUNK_SIZE (1 << 20)
+#endif
+#define MAX_TOKEN_LENGTH 32
+#define INITIAL_SLOTS 1024
+
+/**
+ * @struct Counter
+ * @brief The word counts of one thread.
+ *
+ * @var Counter::words
+ * Member words holds the distinct lowercased words that were counted, indexed by id.
+ * @var Counter::counts
+ * Member counts holds how often each word was counted, indexed by id.
+ * @var Counter::slots
+ * Member slots is the hash table, holding the id of a word or -1 for an empty slot.
+ * @var Counter::slotsCount
+ * Member slotsCount is the number of slots, a power of two.
+ */
+
+struct Counter {
+    WordPool *words;
+    uint32_t *counts;
+    int countsCapacity;
+    int *slots;
+    size_t slotsCount;
+    size_t tokens;
+    size_t skipped;
+};
+typedef struct Counter Counter;
+
+/**
+ * @struct Reader
+ * @brief The input stream and the unfinished token carried over to the next chunk.
+ */
+
+struct Reader {
+    FILE *input;
+    pthread_mutex_t lock;
+    char *carry;
+    size_t carryLength;
+    size_t bytes;
+    bool failed;
+};
+typedef struct Reader Reader;
+
+/**
+ * @struct Worker
+ * @brief The arguments of one counting thread.
+ */
+
+struct Worker {
+    Reader *reader;
+    Counter counter;
+};
+typedef struct Worker Worker;
+
+static bool isLetter(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static bool isTokenByte(char c) {
+    return isLetter(c) || (c >= '0' && c <= '9') || c == '_' || c == '\''
+           || (unsigned char)c >= 0x80;
+}
+
+static size_t hashWord(const char *word, int length) {
+    size_t value = 14695981039346656037ULL;
+    for (int i = 0; i < length; i++) {
+        value = (value ^ (unsigned char)word[i]) * 1099511628211ULL;
+    }
+    return value;
+}
+
+static void initCounter(Counter *counter) {
+    counter->words = initWordPool();
+    counter->countsCapacity = INITIAL_SLOTS;
+    counter->counts = malloc(sizeof(uint32_t) * counter->countsCapacity);
+    counter->slotsCount = INITIAL_SLOTS;
+    counter->slots = malloc(sizeof(int) * counter->slotsCount);
+    memset(counter->slots, -1, sizeof(int) * counter->slotsCount);
+    counter->tokens = 0;
+    counter->skipped = 0;
+}
+
+static void destroyCounter(Counter *counter) {
+    delWordPool(counter->words);
+    free(counter->counts);
+    free(counter->slots);
+}
+
+/**
+ * @brief A helper function that doubles the hash table and puts every word back into it.
+ */
+
+static void growSlots(Counter *counter) {
+    free(counter->slots);
+    counter->slotsCount *= 2;
+    counter->slots = malloc(sizeof(int) * counter->slotsCount);
+    memset(counter->slots, -1, sizeof(int) * counter->slotsCount);
+    size_t mask = counter->slotsCount - 1;
+    for (int id = 0; id < counter->words->count; id++) {
+        WordView view = poolView(counter->words, id);
+        size_t slot = hashWord(view.word, view.length) & mask;
+        while (counter->slots[slot] != -1) {
+            slot = (slot + 1) & mask;
+        }
+        counter->slots[slot] = id;
+    }
+}
+
+/**
+ * @brief A helper function that adds to the count of one lowercased word.
+ */
+
+static void countWord(Counter *counter, const char *word, int length, uint32_t count) {
+    size_t mask = counter->slotsCount - 1;
+    size_t slot = hashWord(word, length) & mask;
+    while (counter->slots[slot] != -1) {
+        WordView view = poolView(counter->words, counter->slots[slot]);
+        if (view.length == length && memcmp(view.word, word, length) == 0) {
+            counter->counts[view.id] += count;
+            return;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    int id = internWord(counter->words, word, length);
+    if (id == counter->countsCapacity) {
+        counter->countsCapacity *= 2;
+        counter->counts = realloc(counter->counts, sizeof(uint32_t) * counter->countsCapacity);
+    }
+    counter->counts[id] = count;
+    counter->slots[slot] = id;
+    if ((size_t)counter->words->count * 2 > counter->slotsCount) {
+        growSlots(counter);
+    }
+}
+
+/**
+ * @brief A helper function that tokenizes a chunk and counts its words.
+ *
+ * Apostrophes at either end of a token are quotes and are dropped. A token that still holds one
+ * is a contraction or a possessive, such as don't or it's, and is skipped as a whole, since
+ * splitting it would count fragments like don and t as words of their own.
+ *
+ * @param[in, out] counter The counts of the thread.
+ * @param[in] chunk The chunk, which does not end inside a token.
+ * @param[in] length The number of bytes of the chunk.
+ */
+
+static void countChunk(Counter *counter, const char *chunk, size_t length) {
+    char word[MAX_TOKEN_LENGTH];
+    size_t i = 0;
+    while (i < length) {
+        if (!isTokenByte(chunk[i])) {
+            i++;
+            continue;
+        }
+        size_t start = i;
+        while (i < length && isTokenByte(chunk[i])) {
+            i++;
+        }
+        size_t end = i;
+        while (start < end && chunk[start] == '\'') {
+            start++;
+        }
+        while (end > start && chunk[end - 1] == '\'') {
+            end--;
+        }
+        if (start == end) {
+            continue;
+        }
+        bool letters = true;
+        for (size_t j = start; j < end; j++) {
+            letters &= isLetter(chunk[j]);
+        }
+        if (!letters || end - start > MAX_TOKEN_LENGTH) {
+            counter->skipped++;
+            continue;
+        }
+        for (size_t j = start; j < end; j++) {
+            word[j - start] = chunk[j] | 0x20;
+        }
+        countWord(counter, word, end - start, 1);
+        counter->tokens++;
+    }
+}
+
+/**
+ * @brief A helper function that reads the next chunk, cut after its last complete token.
+ *
+ * @param[in, out] reader The reader.
+ * @param[out] chunk A buffer of INGEST_CHUNK_SIZE bytes.
+ *
+ * @return The number of bytes of the chunk, 0 once the input is exhausted.
+ */
+
+static size_t readChunk(Reader *reader, char *chunk) {
+    pthread_mutex_lock(&reader->lock);
+    size_t length = reader->carryLength;
+    memcpy(chunk, reader->carry, length);
+    size_t read = fread(chunk + length, 1, INGEST_CHUNK_SIZE - length, reader->input);
+    reader->bytes += read;
+    length += read;
+
+    size_t cut = length;
+    if (read > 0) {
+        while (cut > 0 && isTokenByte(chunk[cut - 1])) {
+            cut--;
+        }
+        if (cut == 0) {
+            cut = length;
+        }
+    } else {
+        reader->failed |= ferror(reader->input) != 0;
+    }
+    reader->carryLength = length - cut;
+    memcpy(reader->carry, chunk + cut, reader->carryLength);
+    pthread_mutex_unlock(&reader->lock);
+    return cut;
+}
+
+/**
+ * @brief A counting thread, which reads and counts chunks until the input is exhausted.
+ *
+ * @param[in] arg The worker.
+ */
+
+static void *countChunks(void *arg) {
+    Worker *worker = arg;
+    char *chunk = malloc(INGEST_CHUNK_SIZE);
+    size_t length;
+    while ((length = readChunk(worker->reader, chunk)) > 0) {
+        countChunk(&worker->counter, chunk, length);
+    }
+    free(chunk);
+    return NULL;
+}
+
+/**
+ * @brief Counts the words of a stream of raw text and adds the counts to the Trie as weights.
+ *
+ * @param[in] root The root of the Trie the words are added to.
+ * @param[in] budget The budget of the Trie, which the counts are added through so that the Trie
+ * never goes over it while the counts are merged, or NULL.
+ * @param[in] input The stream the text is read from.
+ * @param[in] threadsCount The number of threads that tokenize and count the text.
+ * @param[out] stats Receives what was read and counted.
+ *
+ * @return false if the stream could not be read.
+ */
+
+bool ingestText(Node *root, TrieBudget *budget, FILE *input, int threadsCount,
+                IngestStats *stats) {
+    threadsCount = threadsCount > 0 ? threadsCount : 1;
+    Reader reader = {.input = input};
+    pthread_mutex_init(&reader.lock, NULL);
+    reader.carry = malloc(INGEST_CHUNK_SIZE);
+
+    Worker *workers = malloc(sizeof(Worker) * threadsCount);
+    pthread_t *threads = malloc(sizeof(pthread_t) * threadsCount);
+    for (int i = 0; i < threadsCount; i++) {
+        workers[i].reader = &reader;
+        initCounter(&workers[i].counter);
+        pthread_create(&threads[i], NULL, countChunks, &workers[i]);
+    }
+
+    memset(stats, 0, sizeof(IngestStats));
+    for (int i = 0; i < threadsCount; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    Counter *total = &workers[0].counter;
+    for (int i = 0; i < threadsCount; i++) {
+        Counter *counter = &workers[i].counter;
+        for (int id = 0; i > 0 && id < counter->words->count; id++) {
+            WordView view = poolView(counter->words, id);
+            countWord(total, view.word, view.length, counter->counts[id]);
+        }
+        stats->tokens += counter->tokens;
+        stats->skipped += counter->skipped;
+        if (i > 0) {
+            destroyCounter(counter);
+        }
+    }
+    for (int id = 0; id < total->words->count; id++) {
+        Node *current = root;
+        WordView view = poolView(total->words, id);
+        for (int j = 0; j < view.length && current; j++) {
+            current = current->children[view.word[j] - 'a'];
+        }
+        stats->words += current == NULL || !current->isEndOfWord;
+        if (budget) {
+            budgetInsert(budget, view.word, total->counts[id]);
+        } else {
+            insertWeighted(root, view.word, total->counts[id]);
+        }
+    }
+    destroyCounter(total);
+    stats->bytes = reader.bytes;
+
+    free(workers);
+    free(threads);
+    free(reader.carry);
+    pthread_mutex_destroy(&reader.lock);
+    return !reader.failed;
+}
+
+/**
+ * @brief A function to test the ingest mode and all supported operations on it.
+ */
+
+void testIngest() {
+    FILE *text = tmpfile();
+    fputs("The cat, the CAT! caf\xc3\xa9 42 cat9 snake_case don't it's 'cat' dogs' '\n"
+          "Pneumonoultramicroscopicsilicovolcanoconiosis cat", text);
+    rewind(text);
+    Node *root = initTrie();
+    IngestStats stats;
+    assert(ingestText(root, NULL, text, 2, &stats));
+    fclose(text);
+    assert(stats.tokens == 7 && stats.skipped == 7 && stats.words == 3);
+    assert(root->children['c' - 'a']->children[0]->children['t' - 'a']->weight == 4);
+    assert(root->children['d' - 'a']->children['o' - 'a']->children['n' - 'a'] == NULL);
+    assert(!root->children['t' - 'a']->isEndOfWord && root->children['s' - 'a'] == NULL);
+    assert(root->children['t' - 'a']->children['h' - 'a']->children['e' - 'a']->weight == 2);
+    printf("tokenized and counted the words, skipping the rest\n");
+
+    text = tmpfile();
+    for (int i = 0; i < 100000; i++) {
+        fputs("alpha beta\ngamma, ", text);
+    }
+    rewind(text);
+    assert(ingestText(root, NULL, text, 4, &stats));
+    fclose(text);
+    assert(stats.bytes == 1800000 && stats.tokens == 300000 && stats.words == 3);
+    Node *beta = root->children['b' - 'a']->children['e' - 'a']->children['t' - 'a'];
+    assert(beta->children[0]->weight == 100000);
+    printf("counted across chunks and threads, adding to the weights in the Trie\n");
+    delTrie(root);
+
+    text = tmpfile();
+    fputs("alpha alpha alpha beta gamma delta", text);
+    rewind(text);
+    root = initTrie();
+    TrieBudget *budget = initTrieBudget(root, 18 * sizeof(Node));
+    assert(ingestText(root, budget, text, 2, &stats));
+    fclose(text);
+    assert(budget->evictedCount > 0 && budgetMemory(budget) <= budget->limit);
+    assert(root->children[0]->children['l' - 'a']->children['p' - 'a']->children['h' - 'a']
+           ->children[0]->weight == 3);
+    printf("merged the counts within a memory budget\n");
+    delTrieBudget(budget);
+    delTrie(root);
+
+    text = tmpfile();
+    fputs("kiwi ", text);
+    for (int i = 0; i < INGEST_CHUNK_SIZE / 6 + 1; i++) {
+        fputs("alpha ", text);
+    }
+    fputs("kiwi beta", text);
+    rewind(text);
+    root = initTrie();
+    budget = initTrieBudget(root, 40 * sizeof(Node));
+    assert(ingestText(root, budget, text, 2, &stats));
+    fclose(text);
+    assert(root->children['k' - 'a']->children['i' - 'a']->children['w' - 'a']
+           ->children['i' - 'a']->weight == 2);
+    printf("added the total of a word counted on several threads at once\n");
+
+    delTrieBudget(budget);
+    delTrie(root);
+}
@@ -0,0 +1,330 @@
+/**
+ * @file louds.c
+ * @author Arjun Pathak
+ * @brief This file contains the succinct LOUDS encoding of the Trie.
+ *
+ * This file contains the implementations of the functions declared in the louds.h header file.
+ * The bit vector starts with "10" for a virtual super root, followed by the unary degree of every
+ * node in BFS order. With nodes numbered from 0 in that same order, the children of node x are the
+ * consecutive nodes select0(x + 1) - x up to select0(x + 2) - x - 1, and the parent of node y is
+ * select1(y + 1) - y - 1. Because the numbering is level order, the descendants of a node that are
+ * at the same depth are always a consecutive range of ids, so the BFS that predictN() does turns
+ * into walking one range per level with no queue at all.
+ */
+
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "louds.h"
+
+#define BLOCK_BITS 512
+#define BLOCK_WORDS (BLOCK_BITS / 64)
+#define LABEL_BITS 5
+
+static void setBit(uint64_t *words, size_t position) {
+    words[position / 64] |= 1ULL << (position % 64);
+}
+
+static bool getBit(const uint64_t *words, size_t position) {
+    return (words[position / 64] >> (position % 64)) & 1;
+}
+
+static void setLabel(uint64_t *labels, size_t node, unsigned label) {
+    size_t position = node * LABEL_BITS;
+    labels[position / 64] |= (uint64_t)label << (position % 64);
+    if (position % 64 > 64 - LABEL_BITS) {
+        labels[position / 64 + 1] |= (uint64_t)label >> (64 - position % 64);
+    }
+}
+
+static unsigned getLabel(const uint64_t *labels, size_t node) {
+    size_t position = node * LABEL_BITS;
+    uint64_t value = labels[position / 64] >> (position % 64);
+    if (position % 64 > 64 - LABEL_BITS) {
+        value |= labels[position / 64 + 1] << (64 - position % 64);
+    }
+    return value & ((1 << LABEL_BITS) - 1);
+}
+
+/**
+ * @brief A helper function that builds the rank directory of a bit vector.
+ *
+ * @param[in, out] bv The bit vector whose words are already filled in.
+ */
+
+static void buildRanks(BitVector *bv) {
+    size_t blocks = (bv->length + BLOCK_BITS - 1) / BLOCK_BITS;
+    size_t wordsCount = (bv->length + 63) / 64;
+    bv->ranks = malloc(sizeof(uint32_t) * (blocks + 1));
+    uint32_t rank = 0;
+    for (size_t i = 0; i < wordsCount; i++) {
+        if (i % BLOCK_WORDS == 0) {
+            bv->ranks[i / BLOCK_WORDS] = rank;
+        }
+        rank += __builtin_popcountll(bv->words[i]);
+    }
+    bv->ranks[blocks] = rank;
+}
+
+/**
+ * @brief A helper function that returns the position of the k-th set bit of a word.
+ *
+ * @param[in] word The word to be searched.
+ * @param[in] k The 1 based count of the set bit.
+ */
+
+static size_t selectInWord(uint64_t word, size_t k) {
+    for (size_t i = 1; i < k; i++) {
+        word &= word - 1;
+    }
+    return __builtin_ctzll(word);
+}
+
+/**
+ * @brief Returns the position of the k-th 1 bit, or of the k-th 0 bit if zero is set.
+ *
+ * The block that holds the bit is found by a binary search over the rank directory, after which
+ * the words of the block are scanned with popcount and the bit is found inside its word.
+ *
+ * @param[in] bv The bit vector.
+ * @param[in] k The 1 based count of the bit that is searched for.
+ * @param[in] zero If true, 0 bits are counted instead of 1 bits.
+ */
+
+static size_t selectBit(const BitVector *bv, size_t k, bool zero) {
+    size_t low = 0, high = (bv->length + BLOCK_BITS - 1) / BLOCK_BITS - 1;
+    while (low < high) {
+        size_t mid = low + (high - low + 1) / 2;
+        size_t before = zero ? mid * BLOCK_BITS - bv->ranks[mid] : bv->ranks[mid];
+        if (before < k) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+
+    k -= zero ? low * BLOCK_BITS - bv->ranks[low] : bv->ranks[low];
+    for (size_t i = low * BLOCK_WORDS;; i++) {
+        uint64_t word = zero ? ~bv->words[i] : bv->words[i];
+        size_t count = __builtin_popcountll(word);
+        if (k <= count) {
+            return i * 64 + selectInWord(word, k);
+        }
+        k -= count;
+    }
+}
+
+static size_t firstChild(const Louds *louds, size_t node) {
+    return selectBit(&louds->tree, node + 1, true) - node;
+}
+
+static size_t childrenEnd(const Louds *louds, size_t node) {
+    return selectBit(&louds->tree, node + 2, true) - node - 1;
+}
+
+static size_t parent(const Louds *louds, size_t node) {
+    return selectBit(&louds->tree, node + 1, false) - node - 1;
+}
+
+/**
+ * @brief Encodes a built Trie into its succinct form.
+ *
+ * The Trie is walked in BFS order with an array of node pointers, which doubles as the numbering
+ * of the nodes. Every node writes its degree into the LOUDS bit vector and the labels of its
+ * children into the label array.
+ *
+ * @param[in] root The root of a populated Trie.
+ *
+ * @return The newly built encoding.
+ */
+
+Louds *initLouds(Node *root) {
+    size_t capacity = 1024, count = 1;
+    Node **order = malloc(sizeof(Node *) * capacity);
+    order[0] = root;
+    for (size_t i = 0; i < count; i++) {
+        for (int j = 0; j < 26; j++) {
+            if (order[i]->children[j]) {
+                if (count == capacity) {
+                    capacity *= 2;
+                    order = realloc(order, sizeof(Node *) * capacity);
+                }
+                order[count++] = order[i]->children[j];
+            }
+        }
+    }
+
+    Louds *louds = malloc(sizeof(Louds));
+    louds->nodesCount = count;
+    louds->tree.length = 2 * count + 1;
+    louds->tree.words = calloc((louds->tree.length + 63) / 64, sizeof(uint64_t));
+    louds->terminals = calloc((count + 63) / 64, sizeof(uint64_t));
+    louds->labels = calloc((count * LABEL_BITS + 63) / 64 + 1, sizeof(uint64_t));
+
+    size_t position = 0, child = 1;
+    setBit(louds->tree.words, position);
+    position += 2;
+    for (size_t i = 0; i < count; i++) {
+        if (order[i]->isEndOfWord) {
+            setBit(louds->terminals, i);
+        }
+        for (int j = 0; j < 26; j++) {
+            if (order[i]->children[j]) {
+                setBit(louds->tree.words, position++);
+                setLabel(louds->labels, child++, j);
+            }
+        }
+        position++;
+    }
+    buildRanks(&louds->tree);
+    free(order);
+
+    return louds;
+}
+
+/**
+ * @brief A helper function that spells out the word that ends at a node.
+ *
+ * @param[in] louds The encoded Trie.
+ * @param[in] node The node the word ends at.
+ * @param[in] prefix The matched prefix, which spells out the path down to the starting node.
+ * @param[in] depth The number of levels between the starting node and the node.
+ */
+
+static char *spell(const Louds *louds, size_t node, string *prefix, int depth) {
+    char *match = malloc(prefix->length + depth + 1);
+    memcpy(match, prefix->array, prefix->length);
+    match[prefix->length + depth] = '\0';
+    for (int i = prefix->length + depth - 1; i >= prefix->length; i--) {
+        match[i] = 'a' + getLabel(louds->labels, node);
+        node = parent(louds, node);
+    }
+    return match;
+}
+
+/**
+ * @brief Returns the first N matching words, in the same order as predictN().
+ *
+ * The query is walked down from the root by scanning the labels of the children of each node. The
+ * node reached is the first level of the BFS. Every next level is the range of nodes between the
+ * first child of the first node and the last child of the last node of the previous level, and the
+ * terminal nodes in each range are spelled out in order until N words were found.
+ *
+ * @param[in] louds The encoded Trie.
+ * @param[in] word The word to be prefix matched.
+ * @param[in] results The number of results to be returned.
+ *
+ * @return A buffer of results entries, unused entries are set to NULL.
+ */
+
+char **loudsPredictN(Louds *louds, string *word, int results) {
+    sanitize(word);
+    char **resultsBuffer = calloc(results, sizeof(char *));
+
+    size_t node = 0;
+    int count = 0;
+    for (int i = 0; i < word->length; i++) {
+        unsigned index = word->array[i] - 'a';
+        size_t end = childrenEnd(louds, node), next = end;
+        for (size_t child = firstChild(louds, node); child < end; child++) {
+            unsigned label = getLabel(louds->labels, child);
+            if (label >= index) {
+                next = label == index ? child : end;
+                break;
+            }
+        }
+        if (next == end) {
+            break;
+        }
+        node = next;
+        count++;
+    }
+    string *prefix = duplicate(word);
+    prefix->array[count] = '\0';
+    prefix->length = count;
+
+    size_t first = node, last = node + 1;
+    int matches = 0, depth = 0;
+    while (first < last && matches != results) {
+        for (size_t i = first; i < last && matches != results; i++) {
+            if (getBit(louds->terminals, i)) {
+                resultsBuffer[matches++] = spell(louds, i, prefix, depth);
+            }
+        }
+        size_t nextFirst = firstChild(louds, first);
+        last = childrenEnd(louds, last - 1);
+        first = nextFirst;
+        depth++;
+    }
+
+    delString(prefix);
+    return resultsBuffer;
+}
+
+/**
+ * @brief Returns the number of heap bytes that are held by the encoding.
+ *
+ * @param[in] louds The encoded Trie.
+ */
+
+size_t loudsMemory(Louds *louds) {
+    size_t treeWords = (louds->tree.length + 63) / 64;
+    size_t blocks = (louds->tree.length + BLOCK_BITS - 1) / BLOCK_BITS;
+    return sizeof(Louds)
+        + sizeof(uint64_t) * treeWords
+        + sizeof(uint32_t) * (blocks + 1)
+        + sizeof(uint64_t) * ((louds->nodesCount + 63) / 64)
+        + sizeof(uint64_t) * ((louds->nodesCount * LABEL_BITS + 63) / 64 + 1);
+}
+
+/**
+ * @brief Reclaims all the memory held by the encoding.
+ *
+ * @param[in] louds The encoded Trie.
+ */
+
+void delLouds(Louds *louds) {
+    free(louds->tree.words);
+    free(louds->tree.ranks);
+    free(louds->terminals);
+    free(louds->labels);
+    free(louds);
+}
+
+/**
+ * @brief A function to test the LOUDS encoding against the pointer Trie.
+ */
+
+void testLouds() {
+    char *words[6] = {"teleport", "telephone", "telegram", "tea", "a", "zebra"};
+    Node *root = initTrie();
+    for (int i = 0; i < 6; i++) {
+        insert(root, words[i]);
+    }
+    Louds *louds = initLouds(root);
+    assert(louds->nodesCount == 24);
+    printf("encoded the trie\n");
+
+    char *tests[6] = {"tele", "t", "", "abc", "zebra", "telex"};
+    for (int i = 0; i < 6; i++) {
+        string *query = initString(tests[i], strlen(tests[i]));
+        char **expected = predictN(root, query, 4);
+        char **buffer = loudsPredictN(louds, query, 4);
+        for (int j = 0; j < 4; j++) {
+            assert((expected[j] == NULL) == (buffer[j] == NULL));
+            assert(expected[j] == NULL || strcmp(expected[j], buffer[j]) == 0);
+            free(expected[j]);
+            free(buffer[j]);
+        }
+        free(expected);
+        free(buffer);
+        delString(query);
+    }
+    printf("succinct predictions match the trie\n");
+
+    delLouds(louds);
+    delTrie(root);
+}
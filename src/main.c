@@ -7,18 +7,69 @@
  * the words are stored. The word database file must be newline terminated words of the english
  * language. The second argument is the number os results that are expected to be returned at max.
  * This file contains the driver code to parse the command line arguments and start the interactive
- * loop and then accept user input to search the Trie.
+ * loop and then accept user input to search the Trie. Queries that start with a '*' are matched
+ * anywhere inside the words instead of only at their start, using a suffix index that is built the
+ * first time such a query is made. Every word is interned in a word pool as it is read, so the
+ * completions of the trie engine are printed straight from the pool, in the casing the word file
+ * gave them, without copying them.
+ *
+ * Options may be given before the two arguments:
+ *   --cache BYTES   Answer repeated queries from a result cache that holds at most BYTES bytes.
+ *   --batch         Read newline separated queries from stdin and write one line of results per
+ *                   query to stdout, without any of the interactive output.
+ *   --format FORMAT The format of the batch output, either tsv (the default) or json.
+ *   --store DIR     Persist the Trie in the directory DIR. If DIR already holds a snapshot or a
+ *                   log, the Trie is restored from it, and the dictionary argument must be -
+ *                   instead of a word file, unless it is text for --ingest to add its counts
+ *                   to. Words added with the :a command are logged to DIR.
+ *   --engine NAME   Answer the queries with the engine NAME: trie (the default), louds or darray.
+ *                   The louds and darray engines are read-only and cannot be combined with the
+ *                   options that need the pointer Trie: --cache, --store, --corpus, --budget,
+ *                   --ingest and --ranked.
+ *   --corpus FILE   Train a bigram and trigram model on the plain text in FILE. A query made of
+ *                   several words, or ending with a space, then suggests the next word after the
+ *                   last words typed, completing the partial word at the end of the line if any.
+ *   --budget BYTES  Keep the Nodes of the Trie within BYTES bytes, evicting the words with the
+ *                   lowest weight, and the branches only they needed, whenever an insert would
+ *                   go over the budget.
+ *   --tui           Open a full screen interface that completes the query on every keystroke,
+ *                   searching on a worker thread. It needs the trie engine and does not use
+ *                   --cache or --corpus.
+ *   --ingest        Read the dictionary argument as raw text, or stdin if it is -, and count its
+ *                   words on several threads, so that every word gets its frequency as weight.
+ *                   The counts are added to a Trie restored from --store. Text from stdin
+ *                   needs --store, and the program exits once it is counted, so it cannot be combined with --batch or
+ *                   --tui, which read their queries from stdin. It implies --ranked.
+ *   --ranked        Return the completions with the highest weights first, instead of the
+ *                   shortest ones, for dictionaries whose weights were counted by --ingest.
+ *   --threads N     The number of threads --ingest counts on, all the cores by default.
  */
 
 #define INPUT_BUFFER_SIZE 100
 #define EXIT_KEYWORD ":e"
+#define INFIX_MARKER '*'
+#define ADD_KEYWORD ":a"
+#define STORE_GROUP_SIZE 64
+#define MAX_WORDS (INPUT_BUFFER_SIZE / 2)
 
 #include <errno.h>
+#include <getopt.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
+#include "batch.h"
+#include "budget.h"
+#include "cache.h"
+#include "engine.h"
+#include "ingest.h"
+#include "ngram.h"
+#include "pool.h"
+#include "store.h"
+#include "suffix.h"
 #include "trie.h"
+#include "tui.h"
 
 /**
  * @brief The function takes in command line arguments, opens a file, inserts all words into the
@@ -29,48 +80,402 @@
  */
 
 int main(int argc, char *argv[]) {
-    FILE *data;
-    data = fopen(argv[1], "r");
-    if (data == NULL) {
-        printf("Error opening file: %d\n", errno);
+    static struct option options[] = {
+        {"cache", required_argument, NULL, 'c'},
+        {"batch", no_argument, NULL, 'b'},
+        {"format", required_argument, NULL, 'f'},
+        {"store", required_argument, NULL, 's'},
+        {"corpus", required_argument, NULL, 'n'},
+        {"engine", required_argument, NULL, 'e'},
+        {"tui", no_argument, NULL, 't'},
+        {"budget", required_argument, NULL, 'm'},
+        {"ingest", no_argument, NULL, 'i'},
+        {"threads", required_argument, NULL, 'j'},
+        {"ranked", no_argument, NULL, 'r'},
+        {NULL, 0, NULL, 0},
+    };
+    size_t cacheBudget = 0;
+    size_t memoryBudget = 0;
+    char *storeDirectory = NULL;
+    char *corpusPath = NULL;
+    bool batch = false;
+    bool tui = false;
+    bool ingest = false;
+    bool ranked = false;
+    int threadsCount = sysconf(_SC_NPROCESSORS_ONLN);
+    BatchFormat format = BATCH_TSV;
+    const EngineType *engineType = &trieEngine;
+    int option;
+    while ((option = getopt_long(argc, argv, "c:bf:s:n:e:tm:ij:r", options, NULL)) != -1) {
+        switch (option) {
+        case 'c':
+            cacheBudget = strtoull(optarg, NULL, 10);
+            break;
+        case 'b':
+            batch = true;
+            break;
+        case 't':
+            tui = true;
+            break;
+        case 'm':
+            memoryBudget = strtoull(optarg, NULL, 10);
+            if (memoryBudget == 0) {
+                fprintf(stderr, "Invalid memory budget: %s\n", optarg);
+                return -1;
+            }
+            break;
+        case 'i':
+            ingest = true;
+            ranked = true;
+            break;
+        case 'r':
+            ranked = true;
+            break;
+        case 'j':
+            threadsCount = atoi(optarg);
+            if (threadsCount <= 0) {
+                fprintf(stderr, "Invalid number of threads: %s\n", optarg);
+                return -1;
+            }
+            break;
+        case 'f':
+            if (strcmp(optarg, "json") == 0) {
+                format = BATCH_JSON;
+            } else if (strcmp(optarg, "tsv") != 0) {
+                fprintf(stderr, "Unknown batch format: %s\n", optarg);
+                return -1;
+            }
+            break;
+        case 's':
+            storeDirectory = optarg;
+            break;
+        case 'n':
+            corpusPath = optarg;
+            break;
+        case 'e':
+            engineType = findEngineType(optarg);
+            if (engineType == NULL) {
+                fprintf(stderr, "Unknown engine: %s\n", optarg);
+                return -1;
+            }
+            break;
+        default:
+            return -1;
+        }
+    }
+    if (argc - optind < 2) {
+        printf("Usage: %s [--cache BYTES] [--batch [--format tsv|json]] [--store DIR] "
+               "[--corpus FILE] [--engine trie|louds|darray] [--tui] [--budget BYTES] "
+               "[--ingest [--threads N]] [--ranked] dictionary.txt results\n", argv[0]);
+        return -1;
+    }
+    if (engineType != &trieEngine
+        && (cacheBudget || storeDirectory || corpusPath || memoryBudget || ranked)) {
+        fprintf(stderr, "The %s engine cannot be combined with --cache, --store, --corpus, "
+                "--budget, --ingest or --ranked\n", engineType->name);
+        return -1;
+    }
+    if (tui && (batch || engineType != &trieEngine)) {
+        fprintf(stderr, "The TUI needs the trie engine and cannot be combined with --batch\n");
+        return -1;
+    }
+    bool ingestStdin = ingest && strcmp(argv[optind], "-") == 0;
+    if (ingestStdin && (batch || tui || storeDirectory == NULL)) {
+        fprintf(stderr, "Text read from stdin needs --store and cannot be combined with --batch "
+                "or --tui, since there are no queries left to read\n");
         return -1;
     }
 
-    int resultsCount = atoi(argv[2]);
+    FILE *data = NULL;
+    if (ingestStdin) {
+        data = stdin;
+    } else if (strcmp(argv[optind], "-") != 0) {
+        data = fopen(argv[optind], "r");
+        if (data == NULL) {
+            printf("Error opening file: %d\n", errno);
+            return -1;
+        }
+    }
+
+    int resultsCount = atoi(argv[optind + 1]);
     if (resultsCount == 0) {
         printf("Invalid input for numbers of results.\n");
         return -1;
     }
 
-    printf("\nThis is an interactive playground to test out the Trie autocomplete functionality.\n");
-    printf("Type out a word and hit enter to get suggestions based on the input. Enter :e to exit the program.\n");
-    
     Node *root = initTrie();
     char *line = NULL;
     size_t length = 0;
     ssize_t read;
     char input[INPUT_BUFFER_SIZE];
     int wordsCount = 0;
+    SuffixIndex *index = NULL;
+    ResultCache *cache = cacheBudget ? initResultCache(cacheBudget) : NULL;
+    Store *store = NULL;
+    NGramModel *model = NULL;
+    TrieBudget *budget = memoryBudget ? initTrieBudget(root, memoryBudget) : NULL;
+    WordPool *pool = initWordPool();
+    WordView *views = malloc(sizeof(WordView) * resultsCount);
 
-    while ((read = getline(&line, &length, data)) != -1) {
-        insert(root, line);
-        wordsCount++;
+    if (storeDirectory) {
+        store = openStore(storeDirectory, root, budget, STORE_GROUP_SIZE);
+        if (store == NULL) {
+            printf("Error opening the store in %s: %d\n", storeDirectory, errno);
+            return -1;
+        }
+    }
+    bool restored = store && storeHasData(store);
+    if (restored && data && !ingest) {
+        fprintf(stderr, "The store in %s already holds a dictionary, pass - to restore it "
+                "instead of %s, or --ingest to add the counts of its text\n", storeDirectory,
+                argv[optind]);
+        return -1;
+    }
+    if (!restored && data == NULL) {
+        fprintf(stderr, "There is no dictionary to restore, pass a word file instead of -\n");
+        return -1;
+    }
+
+    IngestStats stats = {0};
+    if (!restored || ingest) {
+        if (ingest && !ingestText(root, budget, data, threadsCount, &stats)) {
+            printf("Error reading the text from %s: %d\n", argv[optind], errno);
+            return -1;
+        }
+        wordsCount = stats.words;
+        while (!ingest && (read = getline(&line, &length, data)) != -1) {
+            if (budget) {
+                budgetInsert(budget, line, 1);
+            } else {
+                insertInterned(root, pool, line, 1);
+            }
+            wordsCount++;
+        }
+        if (store && !compactStore(store)) {
+            printf("Error writing the snapshot to %s: %d\n", storeDirectory, errno);
+        }
+    }
+    if (ingestStdin) {
+        printf("%zu words counted in %zu bytes of text on %d threads, %zu new words stored in %s\n",
+               stats.tokens, stats.bytes, threadsCount, stats.words, storeDirectory);
+        closeStore(store);
+        if (budget) {
+            printf("%zu words were evicted to stay within the %zu byte budget\n",
+                   budget->evictedCount, budget->limit);
+            delTrieBudget(budget);
+        }
+        delTrie(root);
+        delWordPool(pool);
+        free(views);
+        return 0;
+    }
+    if (budget || ingest || restored) {
+        internTrie(pool, root);
+    }
+    if (ranked) {
+        engineType = &rankedEngine;
+    }
+    if (cache) {
+        cache->ranked = ranked;
+    }
+    Engine *engine = initEngine(engineType, root);
+    root = engineTrie(engine);
+    if (root == NULL) {
+        delWordPool(pool);
+        pool = NULL;
     }
     
-    printf("%d words added to the Trie from the file %s\n\n", wordsCount, argv[1]);
+    if (batch || tui) {
+        long answered;
+        if (tui) {
+            answered = runTui(root, pool, resultsCount, ranked);
+            if (answered == -1) {
+                fprintf(stderr, "Error setting up the terminal: %d\n", errno);
+            }
+        } else {
+            answered = runBatch(engine, cache, resultsCount, format, stdin, stdout);
+            if (answered == -1) {
+                fprintf(stderr, "Error writing results: %d\n", errno);
+            }
+        }
+        if (cache) {
+            delResultCache(cache);
+        }
+        if (store) {
+            closeStore(store);
+        }
+        delEngine(engine);
+        if (pool) {
+            delWordPool(pool);
+        }
+        if (budget) {
+            delTrieBudget(budget);
+        }
+        free(views);
+        if (data && data != stdin) {
+            fclose(data);
+        }
+        free(line);
+        return answered == -1 ? -1 : 0;
+    }
+
+    printf("\nThis is an interactive playground to test out the Trie autocomplete functionality.\n");
+    printf("Type out a word and hit enter to get suggestions based on the input. Enter :e to exit the program.\n");
+    printf("Start the word with a * to match it anywhere inside the words, for example *phone.\n");
+    printf("Enter :a followed by a word to add it to the Trie.\n");
+    if (restored && !ingest) {
+        printf("Trie restored from the store in %s\n", storeDirectory);
+    } else if (ingest) {
+        printf("%zu words counted in %zu bytes of text on %d threads, %zu distinct words added "
+               "to the Trie, %zu tokens skipped\n", stats.tokens, stats.bytes, threadsCount,
+               stats.words, stats.skipped);
+    } else {
+        printf("%d words added to the Trie from the file %s\n", wordsCount, argv[optind]);
+    }
+    printf("The %s engine holds %zu words in %zu bytes\n", engineType->name, engineCount(engine),
+           engineMemory(engine));
+    if (pool) {
+        printf("The word pool holds %d words in %zu bytes\n", pool->count, poolMemory(pool));
+    }
+    if (budget) {
+        printf("The Trie uses %zu of its %zu byte budget, %zu words were evicted\n",
+               budgetMemory(budget), budget->limit, budget->evictedCount);
+    }
+    if (corpusPath) {
+        FILE *corpus = fopen(corpusPath, "r");
+        if (corpus == NULL) {
+            printf("Error opening file: %d\n", errno);
+            return -1;
+        }
+        model = initNGramModel(root, pool);
+        long tokens = trainNGramModel(model, corpus);
+        fclose(corpus);
+        if (tokens == -1) {
+            printf("Error counting the n-grams of the corpus: %d\n", errno);
+            return -1;
+        }
+        printf("%ld tokens read from the corpus %s, the n-gram model uses %zu bytes\n", tokens,
+               corpusPath, ngramMemory(model));
+        printf("Type a few words to get suggestions for the next one, for example \"the cat \".\n");
+    }
+    printf("\n");
 
     while(true) {
         printf("---------------------------------------------\n");
         
-        scanf("%99s", input);
+        if (fgets(input, INPUT_BUFFER_SIZE, stdin) == NULL) {
+            break;
+        }
+        input[strcspn(input, "\r\n")] = '\0';
+        bool nextWord = model && input[0] && input[strlen(input) - 1] == ' ';
+        char *words[MAX_WORDS];
+        int wordsTyped = 0;
+        for (char *token = strtok(input, " \t"); token; token = strtok(NULL, " \t")) {
+            words[wordsTyped++] = token;
+        }
+        if (wordsTyped == 0) {
+            continue;
+        }
 
-        if (strcmp(input, EXIT_KEYWORD) == 0) {
+        if (strcmp(words[0], EXIT_KEYWORD) == 0) {
             printf("Execution complete.\n");
             break;
         } 
 
-        string *query = initString(input, strlen(input));
-        char **buffer = predictN(root, query, resultsCount);
+        if (strcmp(words[0], ADD_KEYWORD) == 0) {
+            if (wordsTyped < 2) {
+                printf("Usage: %s word\n", ADD_KEYWORD);
+                continue;
+            }
+            int letters = 0;
+            for (char *c = words[1]; *c; c++) {
+                if ((*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z')) {
+                    words[1][letters++] = *c;
+                }
+            }
+            words[1][letters] = '\0';
+            string *word = initString(words[1], letters);
+            sanitize(word);
+            long evicted = 0;
+            if (budget) {
+                if (cache) {
+                    invalidateWord(cache, root, word->array);
+                }
+                evicted = budgetInsert(budget, word->array, 1);
+                if (evicted == -1) {
+                    printf("%s does not fit in the memory budget\n", word->array);
+                    delString(word);
+                    continue;
+                }
+                if (evicted > 0) {
+                    if (cache) {
+                        clearResultCache(cache);
+                    }
+                    printf("Evicted %ld words to stay within the memory budget\n", evicted);
+                }
+            } else if (cache) {
+                cachedInsert(cache, root, word->array);
+            } else if (!engineInsert(engine, word->array)) {
+                printf("The %s engine is read-only\n", engineType->name);
+                delString(word);
+                continue;
+            }
+            if (pool) {
+                insertInterned(root, pool, words[1], 0);
+            }
+            if (store && evicted > 0 && !compactStore(store)) {
+                printf("Error writing a snapshot to the store: %d\n", errno);
+            } else if (store && evicted == 0
+                       && !(logInsert(store, word->array, 1) && syncStore(store))) {
+                printf("Error logging the word to the store: %d\n", errno);
+            }
+            if (index) {
+                delSuffixIndex(index);
+                index = NULL;
+            }
+            printf("Added %s\n", word->array);
+            delString(word);
+            continue;
+        }
+
+        char **buffer = NULL;
+        int found = 0;
+        string *query;
+        if (words[0][0] == INFIX_MARKER) {
+            if (root == NULL) {
+                printf("Infix queries need the trie engine\n");
+                continue;
+            }
+            if (index == NULL) {
+                index = initSuffixIndex(root);
+                printf("Suffix index built over %d words, using %zu bytes\n", index->wordsCount,
+                       suffixIndexMemory(index));
+            }
+            query = initString(words[0] + 1, strlen(words[0] + 1));
+            buffer = searchN(index, query, resultsCount);
+        } else if (model && (wordsTyped > 1 || nextWord)) {
+            int contextCount = nextWord ? wordsTyped : wordsTyped - 1;
+            char *partial = nextWord ? "" : words[wordsTyped - 1];
+            query = initString(partial, strlen(partial));
+            found = predictNext(model, words, contextCount, query, resultsCount, views);
+        } else if (pool && cache == NULL) {
+            query = initString(words[0], strlen(words[0]));
+            found = ranked ? predictRankedViews(root, pool, query, resultsCount, views)
+                           : predictViews(root, pool, query, resultsCount, views);
+        } else {
+            query = initString(words[0], strlen(words[0]));
+            buffer = cache ? cachedPredictN(cache, root, query, resultsCount)
+                           : engineComplete(engine, query, resultsCount);
+        }
+
+        if (buffer == NULL) {
+            for (int i = 0; i < found; i++) {
+                printf("%.*s ", views[i].length, views[i].word);
+            }
+            printf("\n");
+            delString(query);
+            continue;
+        }
 
         for (int i = 0; i < resultsCount; i++) {
             if (buffer[i]) {
@@ -89,9 +494,31 @@ int main(int argc, char *argv[]) {
         delString(query);
     }
 
-    delTrie(root);
+    if (model) {
+        delNGramModel(model);
+    }
+    if (index) {
+        delSuffixIndex(index);
+    }
+    if (cache) {
+        printCacheStats(cache);
+        delResultCache(cache);
+    }
+    if (store) {
+        closeStore(store);
+    }
+    delEngine(engine);
+    if (pool) {
+        delWordPool(pool);
+    }
+    if (budget) {
+        delTrieBudget(budget);
+    }
+    free(views);
     
-    fclose(data);
+    if (data && data != stdin) {
+        fclose(data);
+    }
     if (line) {
         free(line);
     }
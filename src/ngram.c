@@ -0,0 +1,669 @@
+/**
+ * @file ngram.c
+ * @author Arjun Pathak
+ * @brief This file contains the implementation of the n-gram next word model.
+ *
+ * This file contains the implementations of the functions declared in the ngram.h header file.
+ * Training never holds the corpus, or all of its n-grams, in memory. Every n-gram of the corpus is
+ * packed into a single 64 bit key and appended to a fixed size buffer. A full buffer is sorted,
+ * its equal keys are folded into counts and the sorted run is written to a temporary file. Once
+ * the corpus is read, the runs are merged with a min heap and the merged counts are cut into one
+ * range of followers per context, so the memory used for training is the buffer plus the final
+ * tables. Trigrams that were only seen once are dropped during the merge, the usual count cutoff
+ * that keeps the trigram table from growing with every rare word combination of a large corpus.
+ */
+
+#include <string.h>
+#include <strings.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "ngram.h"
+
+#define READ_SIZE (1 << 20)
+#define BUFFER_KEYS (1 << 22)
+#define RUN_CHUNK 4096
+#define MIN_TRIGRAM_COUNT 2
+#define TRIGRAM_BITS 21
+#define TRIGRAM_MASK ((1ULL << TRIGRAM_BITS) - 1)
+
+/**
+ * @struct KeyCount
+ * @brief A packed n-gram and the number of times it was seen, as stored in the runs.
+ */
+
+struct KeyCount {
+    uint64_t key;
+    uint32_t count;
+};
+typedef struct KeyCount KeyCount;
+
+/**
+ * @struct Counts
+ * @brief The buffer of n-grams not counted yet, and the sorted runs written out so far.
+ */
+
+struct Counts {
+    uint64_t *buffer;
+    size_t buffered;
+    FILE **runs;
+    int runsCount;
+    bool failed;
+};
+typedef struct Counts Counts;
+
+/**
+ * @struct Run
+ * @brief A cursor into a sorted run that is read back one chunk at a time during the merge.
+ */
+
+struct Run {
+    FILE *file;
+    KeyCount *chunk;
+    size_t length;
+    size_t position;
+};
+typedef struct Run Run;
+
+/**
+ * @struct Follower
+ * @brief A word that followed a context, used while the followers of a context are sorted.
+ */
+
+struct Follower {
+    uint32_t id;
+    uint32_t count;
+};
+typedef struct Follower Follower;
+
+/**
+ * @brief Creates a model with no n-grams yet, whose vocabulary is the words of the Trie.
+ *
+ * Every word of the Trie is interned first, so that every terminal Node carries the id of its
+ * word. A corpus token can then be mapped to its id by walking the Trie, and an id can be mapped
+ * back to its word through the pool.
+ *
+ * @param[in] root The root of a populated Trie.
+ * @param[in] pool The pool the words of the Trie are interned in.
+ *
+ * @return The newly created model.
+ */
+
+NGramModel *initNGramModel(Node *root, WordPool *pool) {
+    NGramModel *model = calloc(1, sizeof(NGramModel));
+    model->root = root;
+    model->pool = pool;
+    internTrie(pool, root);
+    model->vocabularyCount = pool->count;
+    return model;
+}
+
+/**
+ * @brief A helper function that sorts keys with an LSD radix sort, one byte per pass.
+ *
+ * Passes over a byte that is the same in every key are skipped, which saves most of the passes,
+ * since packed ids only use the low bits of the words they are packed into.
+ *
+ * @param[in, out] keys The keys to be sorted.
+ * @param[in] scratch A buffer of at least length keys.
+ * @param[in] length The number of keys.
+ */
+
+static void radixSort(uint64_t *keys, uint64_t *scratch, size_t length) {
+    uint64_t *from = keys, *to = scratch;
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t counts[256] = {0};
+        for (size_t i = 0; i < length; i++) {
+            counts[from[i] >> shift & 0xff]++;
+        }
+        if (counts[from[0] >> shift & 0xff] == length) {
+            continue;
+        }
+        size_t position = 0;
+        for (int i = 0; i < 256; i++) {
+            size_t count = counts[i];
+            counts[i] = position;
+            position += count;
+        }
+        for (size_t i = 0; i < length; i++) {
+            to[counts[from[i] >> shift & 0xff]++] = from[i];
+        }
+        uint64_t *temp = from;
+        from = to;
+        to = temp;
+    }
+    if (from != keys) {
+        memcpy(keys, from, length * sizeof(uint64_t));
+    }
+}
+
+/**
+ * @brief A helper function that sorts the buffered keys and writes them out as a run.
+ *
+ * The buffer is radix sorted and every run of equal keys is written as a single key and its count, one
+ * chunk at a time, to a new temporary file.
+ *
+ * @param[in, out] counts The counts to flush.
+ */
+
+static void spillRun(Counts *counts) {
+    if (counts->buffered == 0 || counts->failed) {
+        counts->buffered = 0;
+        return;
+    }
+    uint64_t *scratch = malloc(counts->buffered * sizeof(uint64_t));
+    radixSort(counts->buffer, scratch, counts->buffered);
+    free(scratch);
+
+    FILE *file = tmpfile();
+    if (file == NULL) {
+        counts->failed = true;
+        return;
+    }
+    KeyCount chunk[RUN_CHUNK];
+    int length = 0;
+    for (size_t i = 0; i < counts->buffered; i++) {
+        if (length && chunk[length - 1].key == counts->buffer[i]) {
+            chunk[length - 1].count++;
+            continue;
+        }
+        if (length == RUN_CHUNK) {
+            counts->failed |= fwrite(chunk, sizeof(KeyCount), length, file) != (size_t)length;
+            length = 0;
+        }
+        chunk[length].key = counts->buffer[i];
+        chunk[length++].count = 1;
+    }
+    counts->failed |= fwrite(chunk, sizeof(KeyCount), length, file) != (size_t)length;
+    rewind(file);
+
+    counts->runs = realloc(counts->runs, (counts->runsCount + 1) * sizeof(FILE *));
+    counts->runs[counts->runsCount++] = file;
+    counts->buffered = 0;
+}
+
+static void addKey(Counts *counts, uint64_t key) {
+    if (counts->buffered == BUFFER_KEYS) {
+        spillRun(counts);
+    }
+    counts->buffer[counts->buffered++] = key;
+}
+
+/**
+ * @brief A helper function that moves a run on to its next entry, reading a new chunk if needed.
+ *
+ * @return false once the run is exhausted.
+ */
+
+static bool advanceRun(Run *run) {
+    if (++run->position < run->length) {
+        return true;
+    }
+    run->length = fread(run->chunk, sizeof(KeyCount), RUN_CHUNK, run->file);
+    run->position = 0;
+    return run->length > 0;
+}
+
+static uint64_t runKey(Run *run) {
+    return run->chunk[run->position].key;
+}
+
+/**
+ * @brief A helper function that restores the heap property downwards from a position.
+ *
+ * @param[in, out] heap The min heap of runs, ordered by their current key.
+ * @param[in] size The number of runs in the heap.
+ * @param[in] position The position to start from.
+ */
+
+static void siftDown(Run **heap, int size, int position) {
+    while (true) {
+        int smallest = position, left = 2 * position + 1, right = 2 * position + 2;
+        if (left < size && runKey(heap[left]) < runKey(heap[smallest])) {
+            smallest = left;
+        }
+        if (right < size && runKey(heap[right]) < runKey(heap[smallest])) {
+            smallest = right;
+        }
+        if (smallest == position) {
+            return;
+        }
+        Run *temp = heap[position];
+        heap[position] = heap[smallest];
+        heap[smallest] = temp;
+        position = smallest;
+    }
+}
+
+static int compareFollowers(const void *a, const void *b) {
+    const Follower *x = a, *y = b;
+    if (x->count != y->count) {
+        return x->count < y->count ? 1 : -1;
+    }
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+/**
+ * @brief A helper function that sorts the followers of the last context of a table by count.
+ *
+ * @param[in, out] table The table being built.
+ * @param[in, out] followers A scratch buffer, grown when the range does not fit.
+ * @param[in, out] followersCapacity The capacity of the scratch buffer.
+ */
+
+static void sortFollowers(NGramTable *table, Follower **followers, size_t *followersCapacity) {
+    if (table->contextsCount == 0) {
+        return;
+    }
+    size_t start = table->starts[table->contextsCount - 1], end = table->entriesCount;
+    if (end - start > *followersCapacity) {
+        *followersCapacity = end - start;
+        *followers = realloc(*followers, *followersCapacity * sizeof(Follower));
+    }
+    for (size_t i = start; i < end; i++) {
+        (*followers)[i - start].id = table->next[i];
+        (*followers)[i - start].count = table->counts[i];
+    }
+    qsort(*followers, end - start, sizeof(Follower), compareFollowers);
+    for (size_t i = start; i < end; i++) {
+        table->next[i] = (*followers)[i - start].id;
+        table->counts[i] = (*followers)[i - start].count;
+    }
+}
+
+/**
+ * @brief A helper function that merges the runs into the follower ranges of a table.
+ *
+ * The runs are merged in key order with a min heap. Since the context makes up the high bits of a
+ * key, the followers of a context come out of the merge one after the other, and each range is
+ * sorted by count as soon as the next context starts. The runs are closed, which deletes them.
+ *
+ * @param[in, out] counts The counts, whose buffer and runs are freed.
+ * @param[out] table The table to fill.
+ * @param[in] shift The number of low bits of a key that hold the id of the follower.
+ * @param[in] minCount The number of times an n-gram must have been seen to be kept.
+ *
+ * @return false if a run could not be written or read back.
+ */
+
+static bool buildTable(Counts *counts, NGramTable *table, int shift, uint32_t minCount) {
+    spillRun(counts);
+    free(counts->buffer);
+    uint64_t mask = (1ULL << shift) - 1;
+
+    Run *runs = malloc((counts->runsCount ? counts->runsCount : 1) * sizeof(Run));
+    Run **heap = malloc((counts->runsCount ? counts->runsCount : 1) * sizeof(Run *));
+    int size = 0;
+    for (int i = 0; i < counts->runsCount; i++) {
+        runs[i].file = counts->runs[i];
+        runs[i].chunk = malloc(RUN_CHUNK * sizeof(KeyCount));
+        runs[i].length = runs[i].position = 0;
+        if (advanceRun(&runs[i])) {
+            heap[size++] = &runs[i];
+        }
+    }
+    for (int i = size / 2 - 1; i >= 0; i--) {
+        siftDown(heap, size, i);
+    }
+
+    size_t contextsCapacity = 1024, entriesCapacity = 1024, followersCapacity = 0;
+    Follower *followers = NULL;
+    memset(table, 0, sizeof(NGramTable));
+    table->contexts = malloc(contextsCapacity * sizeof(uint64_t));
+    table->starts = malloc((contextsCapacity + 1) * sizeof(uint32_t));
+    table->next = malloc(entriesCapacity * sizeof(uint32_t));
+    table->counts = malloc(entriesCapacity * sizeof(uint32_t));
+
+    while (size > 0) {
+        uint64_t key = runKey(heap[0]);
+        uint32_t count = 0;
+        while (size > 0 && runKey(heap[0]) == key) {
+            count += heap[0]->chunk[heap[0]->position].count;
+            if (!advanceRun(heap[0])) {
+                counts->failed |= ferror(heap[0]->file) != 0;
+                heap[0] = heap[--size];
+            }
+            siftDown(heap, size, 0);
+        }
+        if (count < minCount) {
+            continue;
+        }
+
+        uint64_t context = key >> shift;
+        if (table->contextsCount == 0 || table->contexts[table->contextsCount - 1] != context) {
+            sortFollowers(table, &followers, &followersCapacity);
+            if (table->contextsCount == contextsCapacity) {
+                contextsCapacity *= 2;
+                table->contexts = realloc(table->contexts, contextsCapacity * sizeof(uint64_t));
+                table->starts = realloc(table->starts, (contextsCapacity + 1) * sizeof(uint32_t));
+            }
+            table->contexts[table->contextsCount] = context;
+            table->starts[table->contextsCount++] = table->entriesCount;
+        }
+        if (table->entriesCount == entriesCapacity) {
+            entriesCapacity *= 2;
+            table->next = realloc(table->next, entriesCapacity * sizeof(uint32_t));
+            table->counts = realloc(table->counts, entriesCapacity * sizeof(uint32_t));
+        }
+        table->next[table->entriesCount] = key & mask;
+        table->counts[table->entriesCount++] = count;
+    }
+    sortFollowers(table, &followers, &followersCapacity);
+    table->starts[table->contextsCount] = table->entriesCount;
+
+    size_t contexts = table->contextsCount ? table->contextsCount : 1;
+    size_t entries = table->entriesCount ? table->entriesCount : 1;
+    table->contexts = realloc(table->contexts, contexts * sizeof(uint64_t));
+    table->starts = realloc(table->starts, (table->contextsCount + 1) * sizeof(uint32_t));
+    table->next = realloc(table->next, entries * sizeof(uint32_t));
+    table->counts = realloc(table->counts, entries * sizeof(uint32_t));
+
+    for (int i = 0; i < counts->runsCount; i++) {
+        fclose(runs[i].file);
+        free(runs[i].chunk);
+    }
+    free(counts->runs);
+    free(followers);
+    free(runs);
+    free(heap);
+    return !counts->failed;
+}
+
+static bool trigramsEnabled(NGramModel *model) {
+    return model->vocabularyCount <= (int)TRIGRAM_MASK;
+}
+
+/**
+ * @brief Counts the bigrams and trigrams of a corpus of plain text into the model.
+ *
+ * The corpus is read in large blocks and every letter moves a cursor one step down the Trie, so a
+ * token is mapped to its id the moment it ends, without being copied anywhere. Uppercase letters
+ * are lowercased and every other character ends the current token. A token that is not in the
+ * vocabulary, or one of the characters that end a sentence, breaks the context, so no n-gram
+ * spans an unknown word or a sentence boundary.
+ *
+ * @param[in] model The model, which must not have been trained before.
+ * @param[in] corpus The stream the text is read from.
+ *
+ * @return The number of tokens of the corpus that were found in the vocabulary, or -1 if the
+ * temporary files the n-grams are counted in could not be written.
+ */
+
+long trainNGramModel(NGramModel *model, FILE *corpus) {
+    Counts bigrams = {0}, trigrams = {0};
+    bigrams.buffer = malloc(BUFFER_KEYS * sizeof(uint64_t));
+    trigrams.buffer = malloc(BUFFER_KEYS * sizeof(uint64_t));
+    bool withTrigrams = trigramsEnabled(model);
+
+    char *block = malloc(READ_SIZE);
+    Node *cursor = model->root;
+    bool inWord = false;
+    int64_t previous = -1, beforePrevious = -1;
+    size_t read;
+    while ((read = fread(block, 1, READ_SIZE, corpus)) > 0 || inWord) {
+        if (read == 0) {
+            block[0] = '\n';
+            read = 1;
+        }
+        for (size_t i = 0; i < read; i++) {
+            char c = block[i];
+            if (c >= 'A' && c <= 'Z') {
+                c += 'a' - 'A';
+            }
+            if (c >= 'a' && c <= 'z') {
+                cursor = cursor ? cursor->children[c - 'a'] : NULL;
+                inWord = true;
+                continue;
+            }
+            if (inWord) {
+                int64_t id = cursor && cursor->isEndOfWord ? cursor->id : -1;
+                if (id < 0) {
+                    previous = beforePrevious = -1;
+                } else {
+                    if (previous >= 0) {
+                        addKey(&bigrams, (uint64_t)previous << 32 | id);
+                        if (beforePrevious >= 0 && withTrigrams) {
+                            addKey(&trigrams, (uint64_t)beforePrevious << 2 * TRIGRAM_BITS |
+                                              (uint64_t)previous << TRIGRAM_BITS | id);
+                        }
+                    }
+                    beforePrevious = previous;
+                    previous = id;
+                    model->tokensCount++;
+                }
+                cursor = model->root;
+                inWord = false;
+            }
+            if (c == '.' || c == '!' || c == '?') {
+                previous = beforePrevious = -1;
+            }
+        }
+    }
+    free(block);
+
+    bool built = buildTable(&bigrams, &model->bigrams, 32, 1);
+    built &= buildTable(&trigrams, &model->trigrams, TRIGRAM_BITS, MIN_TRIGRAM_COUNT);
+    return built ? (long)model->tokensCount : -1;
+}
+
+/**
+ * @brief A helper function that finds the range of followers of a context with a binary search.
+ *
+ * @return false if the context never had a follower.
+ */
+
+static bool findContext(NGramTable *table, uint64_t context, size_t *start, size_t *end) {
+    size_t low = 0, high = table->contextsCount;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (table->contexts[middle] < context) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low == table->contextsCount || table->contexts[low] != context) {
+        return false;
+    }
+    *start = table->starts[low];
+    *end = table->starts[low + 1];
+    return true;
+}
+
+/**
+ * @brief A helper function that maps a context word to its id, lowercasing it on the way.
+ *
+ * @return The id of the word, or -1 if it is not in the vocabulary. Words that were added after
+ * the model was created are not in the vocabulary.
+ */
+
+static int64_t lookupId(NGramModel *model, const char *word) {
+    Node *current = model->root;
+    for (const char *c = word; *c && current; c++) {
+        char letter = *c >= 'A' && *c <= 'Z' ? *c + 'a' - 'A' : *c;
+        if (letter < 'a' || letter > 'z') {
+            continue;
+        }
+        current = current->children[letter - 'a'];
+    }
+    if (!current || current == model->root || !current->isEndOfWord) {
+        return -1;
+    }
+    return current->id < model->vocabularyCount ? current->id : -1;
+}
+
+/**
+ * @brief A helper function that adds a result unless it is already in the buffer.
+ *
+ * @return The new number of results.
+ */
+
+static int addResult(WordView *views, int matches, WordView view) {
+    for (int i = 0; i < matches; i++) {
+        if (views[i].id == view.id) {
+            return matches;
+        }
+    }
+    views[matches] = view;
+    return matches + 1;
+}
+
+/**
+ * @brief A helper function that adds the followers of a context that start with the partial word.
+ *
+ * @return The new number of results.
+ */
+
+static int addFollowers(NGramModel *model, NGramTable *table, uint64_t context, string *partial,
+                        WordView *views, int matches, int resultsLength) {
+    size_t start, end;
+    if (!findContext(table, context, &start, &end)) {
+        return matches;
+    }
+    for (size_t i = start; i < end && matches < resultsLength; i++) {
+        WordView view = poolView(model->pool, table->next[i]);
+        if (strncasecmp(view.word, partial->array, partial->length) == 0) {
+            matches = addResult(views, matches, view);
+        }
+    }
+    return matches;
+}
+
+/**
+ * @brief Returns the N most likely next words after a context that start with a partial word, as
+ * views into the pool.
+ *
+ * The followers of the last two context words are tried first, then the followers of the last
+ * word alone, each in the order of how often they were seen. If the partial word is not empty,
+ * the remaining results are filled with its plain prefix completions from the Trie.
+ *
+ * @param[in] model The trained model.
+ * @param[in] context The words before the current one, oldest first.
+ * @param[in] contextCount The number of context words. Only the last two are used.
+ * @param[in] partial The part of the current word typed so far, which may be empty. It is
+ * sanitized in place.
+ * @param[in] resultsLength The number of results to be returned.
+ * @param[out] views Receives the results, it must have room for resultsLength views.
+ *
+ * @return The number of views that were filled in.
+ */
+
+int predictNext(NGramModel *model, char **context, int contextCount, string *partial,
+                int resultsLength, WordView *views) {
+    sanitize(partial);
+    int matches = 0;
+
+    int64_t previous = contextCount > 0 ? lookupId(model, context[contextCount - 1]) : -1;
+    int64_t beforePrevious = contextCount > 1 ? lookupId(model, context[contextCount - 2]) : -1;
+    if (previous >= 0 && beforePrevious >= 0 && trigramsEnabled(model)) {
+        uint64_t key = (uint64_t)beforePrevious << TRIGRAM_BITS | previous;
+        matches = addFollowers(model, &model->trigrams, key, partial, views, matches,
+                               resultsLength);
+    }
+    if (previous >= 0) {
+        matches = addFollowers(model, &model->bigrams, previous, partial, views, matches,
+                               resultsLength);
+    }
+
+    if (partial->length > 0 && matches < resultsLength) {
+        WordView *completions = malloc(resultsLength * sizeof(WordView));
+        int found = predictViews(model->root, model->pool, partial, resultsLength, completions);
+        for (int i = 0; i < found && matches < resultsLength; i++) {
+            if (completions[i].length > 0) {
+                matches = addResult(views, matches, completions[i]);
+            }
+        }
+        free(completions);
+    }
+    return matches;
+}
+
+/**
+ * @brief Returns the number of heap bytes that are held by the model, not counting the pool.
+ *
+ * @param[in] model The model.
+ */
+
+size_t ngramMemory(NGramModel *model) {
+    size_t bytes = sizeof(NGramModel);
+    NGramTable *tables[2] = {&model->bigrams, &model->trigrams};
+    for (int i = 0; i < 2; i++) {
+        bytes += tables[i]->contextsCount * (sizeof(uint64_t) + sizeof(uint32_t)) +
+                 sizeof(uint32_t) + tables[i]->entriesCount * 2 * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+/**
+ * @brief Reclaims all the memory held by the model. The Trie and the pool are not deleted.
+ *
+ * @param[in] model The model.
+ */
+
+void delNGramModel(NGramModel *model) {
+    NGramTable *tables[2] = {&model->bigrams, &model->trigrams};
+    for (int i = 0; i < 2; i++) {
+        free(tables[i]->contexts);
+        free(tables[i]->starts);
+        free(tables[i]->next);
+        free(tables[i]->counts);
+    }
+    free(model);
+}
+
+/**
+ * @brief A function to test the n-gram model and all supported operations on it.
+ */
+
+void testNGramModel() {
+    char *words[8] = {"The", "cat", "sat", "on", "mat", "dog", "ran", "catalog"};
+    Node *root = initTrie();
+    WordPool *pool = initWordPool();
+    for (int i = 0; i < 8; i++) {
+        insertInterned(root, pool, words[i], 1);
+    }
+    NGramModel *model = initNGramModel(root, pool);
+    assert(model->vocabularyCount == 8);
+    assert(lookupId(model, "Cat") == 1 && lookupId(model, "catalog") == 7);
+    printf("mapped the vocabulary to the ids of the pool\n");
+
+    FILE *corpus = tmpfile();
+    fputs("The cat sat on the mat. The cat sat on the mat.\n"
+          "The dog ran! The cat ran. the zebra sat on the dog", corpus);
+    rewind(corpus);
+    assert(trainNGramModel(model, corpus) == 23);
+    fclose(corpus);
+    printf("trained on the corpus\n");
+
+    char *context[2] = {"sat", "on"};
+    WordView views[3];
+    string *partial = initString("", 0);
+    assert(predictNext(model, context, 2, partial, 3, views) == 1);
+    assert(strcmp(views[0].word, "The") == 0);
+    delString(partial);
+
+    context[0] = "on";
+    context[1] = "the";
+    partial = initString("", 0);
+    assert(predictNext(model, context, 2, partial, 3, views) == 3);
+    assert(strcmp(views[0].word, "mat") == 0 && strcmp(views[1].word, "cat") == 0);
+    assert(strcmp(views[2].word, "dog") == 0);
+    delString(partial);
+    printf("predicted the next word from two words of context, backing off to one\n");
+
+    partial = initString("C", 1);
+    assert(predictNext(model, context + 1, 1, partial, 3, views) == 2);
+    assert(strcmp(views[0].word, "cat") == 0 && strcmp(views[1].word, "catalog") == 0);
+    delString(partial);
+    printf("completed the partial word after the context\n");
+
+    insertInterned(root, pool, "cathedral", 1);
+    assert(lookupId(model, "cathedral") == -1);
+    printf("left words added after training out of the vocabulary\n");
+
+    delNGramModel(model);
+    delWordPool(pool);
+    delTrie(root);
+}
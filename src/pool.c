@@ -0,0 +1,299 @@
+/**
+ * @file pool.c
+ * @author Arjun Pathak
+ * @brief This file contains the implementation of the interned word pool.
+ *
+ * This file contains the implementations of the functions declared in the pool.h header file.
+ * The text is kept in chunks that are allocated once and never moved, so a word stays where it
+ * was interned; only the array of chunk pointers and the arrays indexed by id grow to double their
+ * size whenever they run out of room, the same way the custom string type grows. Queries are answered by predictNodes(), which finds
+ * the Nodes of the matching words in the same order as predictN(); each Node then only has to be
+ * turned into a view of the word its id points at.
+ */
+
+#include <string.h>
+#include <strings.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "pool.h"
+
+/**
+ * @brief Creates an empty pool.
+ *
+ * @return The newly created pool.
+ */
+
+WordPool *initWordPool() {
+    WordPool *pool = malloc(sizeof(WordPool));
+    pool->chunksCount = 0;
+    pool->chunksCapacity = 8;
+    pool->chunks = malloc(sizeof(char *) * pool->chunksCapacity);
+    pool->chunkLength = 0;
+    pool->chunkCapacity = 0;
+    pool->textCapacity = 0;
+    pool->count = 0;
+    pool->capacity = 128;
+    pool->words = malloc(sizeof(char *) * pool->capacity);
+    pool->lengths = malloc(sizeof(uint32_t) * pool->capacity);
+    return pool;
+}
+
+/**
+ * @brief Copies a word to the end of the pool and returns its id.
+ *
+ * @param[in] pool The pool.
+ * @param[in] word The word, which does not need to be '\0' terminated.
+ * @param[in] length The number of characters of the word.
+ *
+ * @return The id of the new word.
+ */
+
+int internWord(WordPool *pool, const char *word, int length) {
+    if (pool->chunkLength + length + 1 > pool->chunkCapacity) {
+        if (pool->chunksCount == pool->chunksCapacity) {
+            pool->chunksCapacity *= 2;
+            pool->chunks = realloc(pool->chunks, sizeof(char *) * pool->chunksCapacity);
+        }
+        pool->chunkCapacity = (size_t)length + 1 > POOL_CHUNK_SIZE ? (size_t)length + 1
+                                                                   : POOL_CHUNK_SIZE;
+        pool->chunks[pool->chunksCount++] = malloc(pool->chunkCapacity);
+        pool->chunkLength = 0;
+        pool->textCapacity += pool->chunkCapacity;
+    }
+    if (pool->count == pool->capacity) {
+        pool->capacity *= 2;
+        pool->words = realloc(pool->words, sizeof(char *) * pool->capacity);
+        pool->lengths = realloc(pool->lengths, sizeof(uint32_t) * pool->capacity);
+    }
+    char *text = pool->chunks[pool->chunksCount - 1] + pool->chunkLength;
+    memcpy(text, word, length);
+    text[length] = '\0';
+    pool->chunkLength += length + 1;
+    pool->words[pool->count] = text;
+    pool->lengths[pool->count] = length;
+    return pool->count++;
+}
+
+/**
+ * @brief Returns a view of the word with the given id.
+ *
+ * @param[in] pool The pool.
+ * @param[in] id The id of the word.
+ */
+
+WordView poolView(WordPool *pool, int id) {
+    assert(id >= 0 && id < pool->count);
+    WordView view = {id, pool->words[id], pool->lengths[id]};
+    return view;
+}
+
+/**
+ * @brief Inserts a word into the Trie and interns it, unless the Trie already had it.
+ *
+ * @param[in] root The root of the Trie.
+ * @param[in] pool The pool.
+ * @param[in] word The word to be inserted.
+ * @param[in] weight The weight to be added to the word.
+ *
+ * @return The id of the word.
+ */
+
+int insertInterned(Node *root, WordPool *pool, const char *word, unsigned int weight) {
+    insertWeighted(root, word, weight);
+
+    Node *current = root;
+    int length = 0;
+    for (char c = word[0]; (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); c = word[++length]) {
+        current = current->children[(c | 0x20) - 'a'];
+    }
+    if (current->id == -1) {
+        current->id = internWord(pool, word, length);
+    }
+    return current->id;
+}
+
+/**
+ * @brief A helper function that interns the words below a Node that do not have an id yet.
+ *
+ * @param[in] pool The pool.
+ * @param[in] current The Trie Node being visited.
+ * @param[in, out] path The letters on the path from the root to current.
+ *
+ * @return The number of words that were interned.
+ */
+
+static int internMissing(WordPool *pool, Node *current, string *path) {
+    int interned = 0;
+    if (current->isEndOfWord && current->id == -1) {
+        current->id = internWord(pool, path->array, path->length);
+        interned++;
+    }
+    for (int i = 0; i < 26; i++) {
+        if (current->children[i]) {
+            append(path, 'a' + i);
+            interned += internMissing(pool, current->children[i], path);
+            path->array[--path->length] = '\0';
+        }
+    }
+    return interned;
+}
+
+/**
+ * @brief Interns every word of the Trie that does not have an id yet.
+ *
+ * The Trie only knows the lowercase letters of these words, so that is how they are interned.
+ *
+ * @param[in] pool The pool.
+ * @param[in] root The root of the Trie.
+ *
+ * @return The number of words that were interned.
+ */
+
+int internTrie(WordPool *pool, Node *root) {
+    string *path = initString("", 0);
+    int interned = internMissing(pool, root, path);
+    delString(path);
+    return interned;
+}
+
+/**
+ * @brief Returns the first N matching words in the Trie for a given input word and N, as views
+ * into the pool.
+ *
+ * @param[in] root Root node of the Trie. Every word of the Trie must be in the pool.
+ * @param[in] pool The pool.
+ * @param[in] word Word to be prefix matched. It is sanitized in place.
+ * @param[in] resultsLength The number of results to be returned.
+ * @param[out] views Receives the results, it must have room for resultsLength views.
+ *
+ * @return The number of views that were filled in.
+ */
+
+int predictViews(Node *root, WordPool *pool, string *word, int resultsLength, WordView *views) {
+    Node **nodes = malloc(sizeof(Node *) * (resultsLength > 0 ? resultsLength : 1));
+    int found = predictNodes(root, word, resultsLength, nodes);
+    for (int i = 0; i < found; i++) {
+        views[i] = poolView(pool, nodes[i]->id);
+    }
+    free(nodes);
+    return found;
+}
+
+/**
+ * @brief Returns the N matching words in the Trie with the highest weights, as views into the
+ * pool.
+ *
+ * @param[in] root Root node of the Trie. Every word of the Trie must be in the pool.
+ * @param[in] pool The pool.
+ * @param[in] word Word to be prefix matched. It is sanitized in place.
+ * @param[in] resultsLength The number of results to be returned.
+ * @param[out] views Receives the results, it must have room for resultsLength views.
+ *
+ * @return The number of views that were filled in.
+ */
+
+int predictRankedViews(Node *root, WordPool *pool, string *word, int resultsLength,
+                       WordView *views) {
+    Node **nodes = malloc(sizeof(Node *) * (resultsLength > 0 ? resultsLength : 1));
+    int found = predictRankedNodes(root, word, resultsLength, nodes, NULL);
+    for (int i = 0; i < found; i++) {
+        views[i] = poolView(pool, nodes[i]->id);
+    }
+    free(nodes);
+    return found;
+}
+
+/**
+ * @brief Returns the number of heap bytes that are held by the pool.
+ *
+ * @param[in] pool The pool.
+ */
+
+size_t poolMemory(WordPool *pool) {
+    return sizeof(WordPool) + sizeof(char *) * pool->chunksCapacity + pool->textCapacity
+           + (sizeof(char *) + sizeof(uint32_t)) * pool->capacity;
+}
+
+/**
+ * @brief Reclaims all the memory held by the pool.
+ *
+ * @param[in] pool The pool.
+ */
+
+void delWordPool(WordPool *pool) {
+    for (int i = 0; i < pool->chunksCount; i++) {
+        free(pool->chunks[i]);
+    }
+    free(pool->chunks);
+    free(pool->words);
+    free(pool->lengths);
+    free(pool);
+}
+
+/**
+ * @brief A function to test the word pool and all supported operations on it.
+ */
+
+void testWordPool() {
+    int nWords = 5;
+    char *words[5] = {"Telephone\n", "teleport", "TELEPHONE", "Don't", "telegram"};
+    Node *root = initTrie();
+    WordPool *pool = initWordPool();
+    for (int i = 0; i < nWords; i++) {
+        insertInterned(root, pool, words[i], 1);
+    }
+    assert(pool->count == 4);
+    assert(strcmp(poolView(pool, 0).word, "Telephone") == 0);
+    assert(poolView(pool, 2).length == 3);
+    printf("interned the words, keeping the first casing\n");
+
+    insert(root, "telex");
+    assert(internTrie(pool, root) == 1);
+    assert(strcmp(poolView(pool, 4).word, "telex") == 0);
+    printf("interned the words that were inserted without the pool\n");
+
+    WordView first = poolView(pool, 0);
+    char *longWord = malloc(POOL_CHUNK_SIZE + 1);
+    memset(longWord, 'q', POOL_CHUNK_SIZE);
+    for (int i = 0; i < 2 * POOL_CHUNK_SIZE / 8; i++) {
+        internWord(pool, "interned", 8);
+    }
+    int longId = internWord(pool, longWord, POOL_CHUNK_SIZE);
+    assert(first.word == poolView(pool, 0).word && strcmp(first.word, "Telephone") == 0);
+    assert(poolView(pool, longId).length == POOL_CHUNK_SIZE);
+    assert(strcmp(poolView(pool, longId - 1).word, "interned") == 0);
+    free(longWord);
+    printf("views stay valid while more words are interned\n");
+
+    char *tests[4] = {"tele", "DO", "", "x"};
+    WordView views[3];
+    for (int i = 0; i < 4; i++) {
+        string *query = initString(tests[i], strlen(tests[i]));
+        string *copy = duplicate(query);
+        char **expected = predictN(root, query, 3);
+        int found = predictViews(root, pool, copy, 3, views);
+        for (int j = 0; j < 3; j++) {
+            assert((expected[j] == NULL) == (j >= found));
+            assert(expected[j] == NULL || strcasecmp(expected[j], views[j].word) == 0);
+            assert(expected[j] == NULL || (int)strlen(expected[j]) == views[j].length);
+            free(expected[j]);
+        }
+        free(expected);
+        delString(query);
+        delString(copy);
+    }
+    printf("views match predictN\n");
+
+    insertInterned(root, pool, "Telex", 4);
+    string *query = initString("te", 2);
+    assert(predictRankedViews(root, pool, query, 3, views) == 3);
+    assert(views[0].length == 5 && strncmp(views[0].word, "telex", 5) == 0);
+    delString(query);
+    printf("ranked views put the highest weight first\n");
+
+    delWordPool(pool);
+    delTrie(root);
+}
@@ -34,6 +34,8 @@ static QueueNode *createQueueNode(void *value) {
     QueueNode *node = malloc(sizeof(QueueNode));
     node->value = value;
     node->next = NULL;
+
+    return node;
 }
 
 /**
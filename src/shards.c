@@ -0,0 +1,434 @@
+/**
+ * @file shards.c
+ * @author Arjun Pathak
+ * @brief This file contains the implementation of the sharded multi-dictionary container.
+ *
+ * This file contains the implementations of the functions declared in the shards.h header file.
+ * Every shard owns a separate Trie. A shard that is loaded under a name that is already taken is
+ * built completely before it replaces the old one, so the other shards, and the old version of the
+ * shard itself, stay queryable until the swap. The swap takes the write side of the lock of the
+ * set, which queries hold for reading for as long as they walk the Tries, so the old Trie is only
+ * deleted once no query can still be reading it. Queries start a resumable search on every chosen
+ * shard and merge the words they return with a binary heap, pulling the next word of a shard only
+ * once its previous one is taken, so no shard is searched further than the merge needs.
+ */
+
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "shards.h"
+
+/**
+ * @brief Creates an empty set of shards.
+ *
+ * @return The newly created set.
+ */
+
+ShardSet *initShardSet() {
+    ShardSet *set = malloc(sizeof(ShardSet));
+    set->capacity = 4;
+    set->count = 0;
+    set->shards = malloc(sizeof(Shard) * set->capacity);
+    pthread_rwlock_init(&set->lock, NULL);
+    return set;
+}
+
+/**
+ * @brief A helper function that returns the position of a shard in the set.
+ *
+ * @param[in] set The set to be searched.
+ * @param[in] name The name of the shard.
+ *
+ * @return The position of the shard, or -1 if no shard has the name.
+ */
+
+static int findShard(ShardSet *set, const char *name) {
+    for (int i = 0; i < set->count; i++) {
+        if (strcmp(set->shards[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Loads the words of a file into a shard, replacing the shard if the name is taken.
+ *
+ * The new Trie is built to completion first, without the lock. Only then is it swapped in place
+ * of the Trie that had the same name under the write lock, and the old Trie is deleted once the
+ * lock is released.
+ *
+ * @param[in] set The set the shard belongs to.
+ * @param[in] name The name of the shard.
+ * @param[in] path The path to a newline terminated word file.
+ *
+ * @return The number of words that were loaded, or -1 if the file could not be opened.
+ */
+
+int loadShard(ShardSet *set, const char *name, const char *path) {
+    FILE *data = fopen(path, "r");
+    if (data == NULL) {
+        return -1;
+    }
+
+    Node *root = initTrie();
+    char *line = NULL;
+    size_t length = 0;
+    int wordsCount = 0;
+    while (getline(&line, &length, data) != -1) {
+        insert(root, line);
+        wordsCount++;
+    }
+    free(line);
+    fclose(data);
+
+    pthread_rwlock_wrlock(&set->lock);
+    int position = findShard(set, name);
+    if (position != -1) {
+        Node *old = set->shards[position].root;
+        set->shards[position].root = root;
+        set->shards[position].wordsCount = wordsCount;
+        pthread_rwlock_unlock(&set->lock);
+        delTrie(old);
+        return wordsCount;
+    }
+
+    if (set->count == set->capacity) {
+        set->capacity *= 2;
+        set->shards = realloc(set->shards, sizeof(Shard) * set->capacity);
+    }
+    Shard *shard = &set->shards[set->count++];
+    shard->name = malloc(strlen(name) + 1);
+    strcpy(shard->name, name);
+    shard->root = root;
+    shard->wordsCount = wordsCount;
+    pthread_rwlock_unlock(&set->lock);
+    return wordsCount;
+}
+
+/**
+ * @brief Removes a shard from the set and reclaims its memory.
+ *
+ * The last shard of the array is moved into the slot of the removed one.
+ *
+ * @param[in] set The set the shard belongs to.
+ * @param[in] name The name of the shard.
+ *
+ * @return true if the shard was found and removed.
+ */
+
+bool unloadShard(ShardSet *set, const char *name) {
+    pthread_rwlock_wrlock(&set->lock);
+    int position = findShard(set, name);
+    if (position == -1) {
+        pthread_rwlock_unlock(&set->lock);
+        return false;
+    }
+    Shard removed = set->shards[position];
+    set->shards[position] = set->shards[--set->count];
+    pthread_rwlock_unlock(&set->lock);
+    delTrie(removed.root);
+    free(removed.name);
+    return true;
+}
+
+/**
+ * @struct Cursor
+ * @brief The search of a single shard and the word it returned last.
+ */
+
+struct Cursor {
+    Completion *completion;
+    char *word;
+};
+typedef struct Cursor Cursor;
+
+/**
+ * @brief A helper function that orders two words the same way predictN() does.
+ *
+ * predictN() does a BFS with the children visited in alphabetical order, so its results are
+ * sorted by length first and alphabetically among words of the same length.
+ */
+
+static int compareWords(const char *a, const char *b) {
+    size_t lengthA = strlen(a), lengthB = strlen(b);
+    if (lengthA != lengthB) {
+        return lengthA < lengthB ? -1 : 1;
+    }
+    return strcmp(a, b);
+}
+
+static int compareCursors(Cursor *a, Cursor *b) {
+    return compareWords(a->word, b->word);
+}
+
+/**
+ * @brief A helper function that restores the heap property downwards from a position.
+ *
+ * @param[in, out] heap The min heap of cursors.
+ * @param[in] size The number of cursors in the heap.
+ * @param[in] position The position of the cursor that may be out of place.
+ */
+
+static void siftDown(Cursor *heap, int size, int position) {
+    while (true) {
+        int smallest = position;
+        int left = 2 * position + 1, right = 2 * position + 2;
+        if (left < size && compareCursors(&heap[left], &heap[smallest]) < 0) {
+            smallest = left;
+        }
+        if (right < size && compareCursors(&heap[right], &heap[smallest]) < 0) {
+            smallest = right;
+        }
+        if (smallest == position) {
+            return;
+        }
+        Cursor temp = heap[position];
+        heap[position] = heap[smallest];
+        heap[smallest] = temp;
+        position = smallest;
+    }
+}
+
+/**
+ * @brief A helper function that returns the length of the longest prefix of a sanitized word
+ * that a shard holds.
+ */
+
+static int matchedDepth(Node *root, string *word) {
+    int depth = 0;
+    while (depth < word->length && root->children[word->array[depth] - 'a']) {
+        root = root->children[word->array[depth++] - 'a'];
+    }
+    return depth;
+}
+
+/**
+ * @brief Returns the first N matching words over a chosen set of shards.
+ *
+ * Like predictN() on a single Trie, a query that is not held in full is answered with the words
+ * below its longest prefix that is held, but that prefix is the longest one over all the chosen
+ * shards. Shards that only hold a shorter prefix of the query are left out, since their words are
+ * not completions of the prefix predictN() would have matched on the union of the shards.
+ *
+ * A search is started on every shard that is left. A min heap holds a cursor for each shard that still
+ * has words; the smallest word is taken out of the heap, the cursor resumes its search for the
+ * next word of its shard and is sifted back down. A word that is present in several shards comes
+ * out of the heap several times in a row, and only the first copy is kept. The merge stops once N
+ * words have been taken, so each shard is searched for at most N words plus its duplicates, and
+ * usually far fewer.
+ *
+ * @param[in] set The set of shards.
+ * @param[in] names The names of the shards to be queried. If NULL, all shards are queried.
+ * @param[in] namesCount The number of entries in names.
+ * @param[in] word The word to be prefix matched.
+ * @param[in] results The number of results to be returned.
+ *
+ * @return A buffer of results entries, unused entries are set to NULL.
+ */
+
+char **predictShards(ShardSet *set, const char **names, int namesCount, string *word,
+                     int results) {
+    pthread_rwlock_rdlock(&set->lock);
+    if (names == NULL) {
+        namesCount = set->count;
+    }
+    Cursor *heap = malloc(sizeof(Cursor) * (namesCount + 1));
+    int size = 0;
+
+    sanitize(word);
+    int *depths = malloc(sizeof(int) * (namesCount + 1));
+    int deepest = 0;
+    for (int i = 0; i < namesCount; i++) {
+        int position = names == NULL ? i : findShard(set, names[i]);
+        depths[i] = position == -1 ? -1 : matchedDepth(set->shards[position].root, word);
+        deepest = depths[i] > deepest ? depths[i] : deepest;
+    }
+
+    for (int i = 0; i < namesCount; i++) {
+        int position = names == NULL ? i : findShard(set, names[i]);
+        if (position == -1 || depths[i] != deepest) {
+            continue;
+        }
+        Completion *completion = initCompletion(set->shards[position].root, word);
+        char *first = nextCompletion(completion);
+        if (first == NULL) {
+            delCompletion(completion);
+            continue;
+        }
+        heap[size].completion = completion;
+        heap[size].word = first;
+        size++;
+    }
+    free(depths);
+    for (int i = size / 2 - 1; i >= 0; i--) {
+        siftDown(heap, size, i);
+    }
+
+    char **resultsBuffer = calloc(results, sizeof(char *));
+    int matches = 0;
+    while (size > 0 && matches != results) {
+        Cursor *top = &heap[0];
+        if (matches == 0 || strcmp(resultsBuffer[matches - 1], top->word) != 0) {
+            resultsBuffer[matches++] = top->word;
+        } else {
+            free(top->word);
+        }
+
+        top->word = nextCompletion(top->completion);
+        if (top->word == NULL) {
+            delCompletion(top->completion);
+            heap[0] = heap[--size];
+        }
+        siftDown(heap, size, 0);
+    }
+
+    for (int i = 0; i < size; i++) {
+        free(heap[i].word);
+        delCompletion(heap[i].completion);
+    }
+    free(heap);
+    pthread_rwlock_unlock(&set->lock);
+
+    return resultsBuffer;
+}
+
+/**
+ * @brief Unloads all the shards and deletes the set.
+ *
+ * @param[in] set The set to be deleted.
+ */
+
+void delShardSet(ShardSet *set) {
+    for (int i = 0; i < set->count; i++) {
+        delTrie(set->shards[i].root);
+        free(set->shards[i].name);
+    }
+    free(set->shards);
+    pthread_rwlock_destroy(&set->lock);
+    free(set);
+}
+
+/**
+ * @brief A function to test the shard set and all supported operations on it.
+ */
+
+/**
+ * @brief A shard that testShards() reloads from another thread while it queries the set.
+ *
+ * @var Reload::set
+ * Member set is the set that holds the shard.
+ * @var Reload::path
+ * Member path is the file the shard is loaded from.
+ * @var Reload::rounds
+ * Member rounds is the number of times the shard is loaded.
+ */
+
+struct Reload {
+    ShardSet *set;
+    const char *path;
+    int rounds;
+};
+typedef struct Reload Reload;
+
+/**
+ * @brief A helper function that loads the same shard over and over again.
+ * @param[in] argument The Reload to run.
+ * @return NULL.
+ */
+
+static void *reloadShard(void *argument) {
+    Reload *reload = argument;
+    for (int i = 0; i < reload->rounds; i++) {
+        loadShard(reload->set, "b", reload->path);
+    }
+    return NULL;
+}
+
+void testShards() {
+    char directory[] = "/tmp/rmm_shards_XXXXXX";
+    assert(mkdtemp(directory) != NULL);
+    char paths[2][64];
+    snprintf(paths[0], sizeof(paths[0]), "%s/en.txt", directory);
+    snprintf(paths[1], sizeof(paths[1]), "%s/de.txt", directory);
+    char *contents[2] = {"telephone\nteleport\ntea\n", "telefon\ntee\ntea\n"};
+    for (int i = 0; i < 2; i++) {
+        FILE *file = fopen(paths[i], "w");
+        fputs(contents[i], file);
+        fclose(file);
+    }
+
+    ShardSet *set = initShardSet();
+    assert(loadShard(set, "en", paths[0]) == 3);
+    assert(loadShard(set, "de", paths[1]) == 3);
+    assert(loadShard(set, "fr", "/nonexistent/path") == -1);
+    printf("loaded two shards\n");
+
+    string *query = initString("te", 2);
+    char **buffer = predictShards(set, NULL, 0, query, 4);
+    assert(strcmp(buffer[0], "tea") == 0);
+    assert(strcmp(buffer[1], "tee") == 0);
+    assert(strcmp(buffer[2], "telefon") == 0);
+    assert(strcmp(buffer[3], "teleport") == 0);
+    printf("merged results across all shards\n");
+    for (int i = 0; i < 4; i++) {
+        free(buffer[i]);
+    }
+    free(buffer);
+
+    const char *names[1] = {"de"};
+    buffer = predictShards(set, names, 1, query, 4);
+    assert(strcmp(buffer[2], "telefon") == 0);
+    assert(buffer[3] == NULL);
+    printf("queried a chosen shard\n");
+    for (int i = 0; i < 4; i++) {
+        free(buffer[i]);
+    }
+    free(buffer);
+
+    assert(unloadShard(set, "de"));
+    assert(!unloadShard(set, "de"));
+    assert(set->count == 1);
+    printf("unloaded a shard\n");
+
+    delString(query);
+    delShardSet(set);
+
+    set = initShardSet();
+    contents[0] = "tea\n";
+    contents[1] = "text\n";
+    for (int i = 0; i < 2; i++) {
+        FILE *file = fopen(paths[i], "w");
+        fputs(contents[i], file);
+        fclose(file);
+        loadShard(set, i == 0 ? "a" : "b", paths[i]);
+    }
+    query = initString("tex", 3);
+    buffer = predictShards(set, NULL, 0, query, 2);
+    assert(strcmp(buffer[0], "text") == 0 && buffer[1] == NULL);
+    printf("left out the shards that match a shorter prefix\n");
+    free(buffer[0]);
+    free(buffer);
+
+    Reload reload = {.set = set, .path = paths[1], .rounds = 200};
+    pthread_t thread;
+    pthread_create(&thread, NULL, reloadShard, &reload);
+    for (int i = 0; i < 200; i++) {
+        buffer = predictShards(set, NULL, 0, query, 2);
+        assert(strcmp(buffer[0], "text") == 0 && buffer[1] == NULL);
+        free(buffer[0]);
+        free(buffer);
+    }
+    pthread_join(thread, NULL);
+    printf("queried a shard while it was reloaded\n");
+
+    delString(query);
+    delShardSet(set);
+    remove(paths[0]);
+    remove(paths[1]);
+    rmdir(directory);
+}
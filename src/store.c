@@ -0,0 +1,510 @@
+/**
+ * @file store.c
+ * @author Arjun Pathak
+ * @brief This file contains the implementation of the persistent Trie store.
+ *
+ * This file contains the implementations of the functions declared in the store.h header file.
+ * A store directory holds one snapshot file and one or more log files named log.<generation>.
+ * The snapshot is the Trie in pre-order: every node is written as a 32 bit word with one bit per
+ * child and a high bit for the end of a word, followed by the weight of the word if there is one.
+ * It starts with a header holding the generation of the first log that is not included in it.
+ * The logs are plain text, one "word<TAB>weight" line per insert, so a torn write at the end of a
+ * log is just an unfinished last line that recovery cuts off.
+ *
+ * Compaction writes the snapshot to a temporary file and renames it over the old one before the
+ * old log is deleted, so a crash at any point leaves either the old snapshot with all of its logs
+ * or the new snapshot, and no insert is ever replayed twice.
+ *
+ * A Trie under a memory budget cannot be read from the snapshot Node by Node, since the snapshot
+ * may hold more Nodes than the budget. Its words are spelled out of the snapshot instead and
+ * inserted through the budget, one at a time, the same way the logs are replayed.
+ */
+
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "store.h"
+
+#define SNAPSHOT_MAGIC "RMMSNAP1"
+#define END_OF_WORD_BIT (1u << 31)
+#define IO_BUFFER_SIZE (1 << 20)
+#define COMPACT_MIN_BYTES (1 << 20)
+
+/**
+ * @brief A helper function that returns the path to a file of the store.
+ *
+ * @param[in] store The store.
+ * @param[in] name The name of the file.
+ * @param[in] generation The generation appended to the name, or -1 for none.
+ *
+ * @return A heap allocated path that the caller must free.
+ */
+
+static char *pathOf(Store *store, const char *name, long generation) {
+    size_t length = strlen(store->directory) + strlen(name) + 32;
+    char *path = malloc(length);
+    if (generation < 0) {
+        snprintf(path, length, "%s/%s", store->directory, name);
+    } else {
+        snprintf(path, length, "%s/%s.%ld", store->directory, name, generation);
+    }
+    return path;
+}
+
+static bool syncDirectory(Store *store) {
+    int fd = open(store->directory, O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+}
+
+/**
+ * @brief A helper function that writes a node and everything below it to the snapshot.
+ */
+
+static bool writeNode(FILE *file, Node *node) {
+    uint32_t header = node->isEndOfWord ? END_OF_WORD_BIT : 0;
+    for (int i = 0; i < 26; i++) {
+        if (node->children[i]) {
+            header |= 1u << i;
+        }
+    }
+    if (fwrite(&header, sizeof(header), 1, file) != 1) {
+        return false;
+    }
+    if (node->isEndOfWord && fwrite(&node->weight, sizeof(node->weight), 1, file) != 1) {
+        return false;
+    }
+    for (int i = 0; i < 26; i++) {
+        if (node->children[i] && !writeNode(file, node->children[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief A helper function that reads a node and everything below it from the snapshot.
+ *
+ * The nodes are created directly from the child bits, so loading a snapshot costs one read per
+ * node instead of one insert per word. The maxWeight of every node is worked out on the way back
+ * up.
+ */
+
+static bool readNode(FILE *file, Node *node) {
+    uint32_t header;
+    if (fread(&header, sizeof(header), 1, file) != 1) {
+        return false;
+    }
+    if (header & END_OF_WORD_BIT) {
+        node->isEndOfWord = true;
+        if (fread(&node->weight, sizeof(node->weight), 1, file) != 1) {
+            return false;
+        }
+        node->maxWeight = node->weight;
+    }
+    for (int i = 0; i < 26; i++) {
+        if (header & (1u << i)) {
+            node->children[i] = initTrie();
+            if (!readNode(file, node->children[i])) {
+                return false;
+            }
+            if (node->maxWeight < node->children[i]->maxWeight) {
+                node->maxWeight = node->children[i]->maxWeight;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief A helper function that reads a node and everything below it from the snapshot, and
+ * inserts the words it spells through a budget.
+ *
+ * @param[in] file The snapshot.
+ * @param[in] budget The budget the words are inserted through.
+ * @param[in, out] path The letters that lead to the node.
+ *
+ * @return false if the snapshot could not be read.
+ */
+
+static bool readBudgeted(FILE *file, TrieBudget *budget, string *path) {
+    uint32_t header;
+    if (fread(&header, sizeof(header), 1, file) != 1) {
+        return false;
+    }
+    if (header & END_OF_WORD_BIT) {
+        unsigned int weight;
+        if (fread(&weight, sizeof(weight), 1, file) != 1) {
+            return false;
+        }
+        budgetInsert(budget, path->array, weight);
+    }
+    for (int i = 0; i < 26; i++) {
+        if (header & (1u << i)) {
+            append(path, 'a' + i);
+            if (!readBudgeted(file, budget, path)) {
+                return false;
+            }
+            path->array[--path->length] = '\0';
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief A helper function that loads the snapshot, if there is one.
+ *
+ * @param[in] store The store.
+ * @param[in] budget The budget the words are inserted through, or NULL to read the Nodes directly.
+ *
+ * @return false if a snapshot exists but could not be read.
+ */
+
+static bool loadSnapshot(Store *store, TrieBudget *budget) {
+    char *path = pathOf(store, "snapshot", -1);
+    FILE *file = fopen(path, "rb");
+    free(path);
+    if (file == NULL) {
+        return true;
+    }
+    setvbuf(file, NULL, _IOFBF, IO_BUFFER_SIZE);
+
+    char magic[8];
+    uint64_t generation;
+    bool loaded = fread(magic, sizeof(magic), 1, file) == 1
+        && memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) == 0
+        && fread(&generation, sizeof(generation), 1, file) == 1;
+    if (loaded && budget) {
+        string *path = initString("", 0);
+        loaded = readBudgeted(file, budget, path);
+        delString(path);
+    } else if (loaded) {
+        loaded = readNode(file, store->root);
+    }
+    if (loaded) {
+        store->generation = generation;
+        store->snapshotBytes = ftell(file);
+        store->recovered = true;
+    }
+    fclose(file);
+    return loaded;
+}
+
+/**
+ * @brief A helper function that replays a log into the Trie.
+ *
+ * An unfinished last line is the trace of a write that was cut short by a crash. It is ignored,
+ * and cut off the file so that new inserts are appended after the last complete one.
+ *
+ * @param[in] store The store.
+ * @param[in] generation The generation of the log.
+ * @param[in] budget The budget the inserts are replayed through, or NULL.
+ *
+ * @return false if the log does not exist.
+ */
+
+static bool replayLog(Store *store, unsigned long generation, TrieBudget *budget) {
+    char *path = pathOf(store, "log", generation);
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        free(path);
+        return false;
+    }
+    setvbuf(file, NULL, _IOFBF, IO_BUFFER_SIZE);
+
+    char *line = NULL;
+    size_t length = 0;
+    ssize_t read;
+    long complete = 0;
+    while ((read = getline(&line, &length, file)) != -1 && line[read - 1] == '\n') {
+        char *tab = strchr(line, '\t');
+        if (tab) {
+            *tab = '\0';
+            if (budget) {
+                budgetInsert(budget, line, strtoul(tab + 1, NULL, 10));
+            } else {
+                insertWeighted(store->root, line, strtoul(tab + 1, NULL, 10));
+            }
+        }
+        complete += read;
+    }
+    if (read != -1 && truncate(path, complete) != 0) {
+        perror("Error cutting off the unfinished end of the log");
+    }
+    free(line);
+    fclose(file);
+    free(path);
+
+    store->generation = generation;
+    store->logBytes = complete;
+    store->recovered = store->recovered || complete > 0;
+    return true;
+}
+
+/**
+ * @brief Opens a store directory and recovers the Trie that was persisted in it.
+ *
+ * The snapshot is loaded first, which sets the generation of the first log to replay. The logs are
+ * then replayed in order until one is missing; the last of them stays the current log. Logs older
+ * than the snapshot are left over from a compaction that was cut short, and are deleted.
+ *
+ * @param[in] directory The path to an existing directory.
+ * @param[in] root An empty Trie that the persisted words are loaded into.
+ * @param[in] budget The budget of the Trie, which the persisted words are inserted through so
+ * that the Trie never goes over it while it is recovered, or NULL.
+ * @param[in] groupSize The number of inserts after which the log is fsync()ed.
+ *
+ * @return The opened store, or NULL if the files in the directory could not be read or created.
+ */
+
+Store *openStore(const char *directory, Node *root, TrieBudget *budget, int groupSize) {
+    Store *store = calloc(1, sizeof(Store));
+    store->directory = malloc(strlen(directory) + 1);
+    strcpy(store->directory, directory);
+    store->root = root;
+    store->groupSize = groupSize > 0 ? groupSize : 1;
+
+    if (!loadSnapshot(store, budget)) {
+        closeStore(store);
+        return NULL;
+    }
+    unsigned long snapshotGeneration = store->generation;
+    for (unsigned long generation = snapshotGeneration; replayLog(store, generation, budget);
+         generation++);
+    for (unsigned long generation = snapshotGeneration; generation-- > 0;) {
+        char *path = pathOf(store, "log", generation);
+        int removed = unlink(path);
+        free(path);
+        if (removed != 0) {
+            break;
+        }
+    }
+
+    char *path = pathOf(store, "log", store->generation);
+    store->log = fopen(path, "a");
+    free(path);
+    if (store->log == NULL) {
+        closeStore(store);
+        return NULL;
+    }
+    return store;
+}
+
+/**
+ * @brief Returns true if the store had a snapshot or a log to recover the Trie from.
+ *
+ * @param[in] store The store.
+ */
+
+bool storeHasData(Store *store) {
+    return store->recovered;
+}
+
+/**
+ * @brief Forces the logged inserts that are still pending to disk.
+ *
+ * The inserts only stop being pending once the log was both flushed and synced, so a failed sync
+ * is retried by the next call instead of being reported as done.
+ *
+ * @param[in] store The store.
+ *
+ * @return false if the log could not be written.
+ */
+
+bool syncStore(Store *store) {
+    if (store->pending == 0) {
+        return true;
+    }
+    if (fflush(store->log) != 0 || fsync(fileno(store->log)) != 0) {
+        return false;
+    }
+    store->pending = 0;
+    return true;
+}
+
+/**
+ * @brief Appends an insert to the log.
+ *
+ * The line goes into the stdio buffer of the log. Every groupSize inserts the buffer is written
+ * out and fsync()ed in one go, which is the group commit: a crash may lose the inserts of the
+ * current group, but never a group that was committed. When the log has grown to half the size of
+ * the snapshot, the store is compacted.
+ *
+ * @param[in] store The store.
+ * @param[in] word The word that was inserted.
+ * @param[in] weight The weight the word was inserted with.
+ *
+ * @return false if the log could not be written.
+ */
+
+bool logInsert(Store *store, const char *word, unsigned int weight) {
+    int length = 0;
+    while (word[length] >= 'a' && word[length] <= 'z') {
+        length++;
+    }
+    int written = fprintf(store->log, "%.*s\t%u\n", length, word, weight);
+    if (written < 0) {
+        return false;
+    }
+    store->logBytes += written;
+    if (++store->pending >= store->groupSize && !syncStore(store)) {
+        return false;
+    }
+    if (store->logBytes > COMPACT_MIN_BYTES && store->logBytes > store->snapshotBytes / 2) {
+        return compactStore(store);
+    }
+    return true;
+}
+
+/**
+ * @brief Writes a snapshot of the whole Trie and starts a new, empty log.
+ *
+ * The snapshot is stamped with the next generation, written to a temporary file, fsync()ed and
+ * renamed over the old snapshot. Only then is the new log opened and the old one deleted.
+ *
+ * @param[in] store The store.
+ *
+ * @return false if the snapshot could not be written, in which case the old files stay in use.
+ */
+
+bool compactStore(Store *store) {
+    if (!syncStore(store)) {
+        return false;
+    }
+    uint64_t generation = store->generation + 1;
+    char *temporary = pathOf(store, "snapshot.tmp", -1);
+    FILE *file = fopen(temporary, "wb");
+    if (file == NULL) {
+        free(temporary);
+        return false;
+    }
+    setvbuf(file, NULL, _IOFBF, IO_BUFFER_SIZE);
+    bool written = fwrite(SNAPSHOT_MAGIC, 8, 1, file) == 1
+        && fwrite(&generation, sizeof(generation), 1, file) == 1
+        && writeNode(file, store->root)
+        && fflush(file) == 0
+        && fsync(fileno(file)) == 0;
+    long snapshotBytes = ftell(file);
+    fclose(file);
+
+    char *snapshot = pathOf(store, "snapshot", -1);
+    written = written && rename(temporary, snapshot) == 0 && syncDirectory(store);
+    if (!written) {
+        unlink(temporary);
+    }
+    free(temporary);
+    free(snapshot);
+    if (!written) {
+        return false;
+    }
+
+    char *oldLog = pathOf(store, "log", store->generation);
+    char *newLog = pathOf(store, "log", generation);
+    fclose(store->log);
+    store->log = fopen(newLog, "a");
+    unlink(oldLog);
+    free(oldLog);
+    free(newLog);
+
+    store->generation = generation;
+    store->snapshotBytes = snapshotBytes;
+    store->logBytes = 0;
+    return store->log != NULL;
+}
+
+/**
+ * @brief Syncs the log and closes the store. The Trie itself is not deleted.
+ *
+ * @param[in] store The store.
+ */
+
+void closeStore(Store *store) {
+    if (store->log) {
+        syncStore(store);
+        fclose(store->log);
+    }
+    free(store->directory);
+    free(store);
+}
+
+/**
+ * @brief A function to test the store and all supported operations on it.
+ */
+
+void testStore() {
+    char directory[] = "/tmp/rmm_store_XXXXXX";
+    assert(mkdtemp(directory) != NULL);
+
+    Node *root = initTrie();
+    Store *store = openStore(directory, root, NULL, 2);
+    assert(store != NULL && !storeHasData(store));
+    insertWeighted(root, "telephone", 3);
+    logInsert(store, "telephone", 3);
+    insert(root, "teleport");
+    logInsert(store, "teleport", 1);
+    closeStore(store);
+    delTrie(root);
+    printf("logged two inserts\n");
+
+    root = initTrie();
+    store = openStore(directory, root, NULL, 2);
+    assert(store != NULL && storeHasData(store));
+    assert(root->children['t' - 'a']->children['e' - 'a'] != NULL);
+    assert(compactStore(store));
+    insert(root, "tea");
+    logInsert(store, "tea", 1);
+    closeStore(store);
+    delTrie(root);
+    printf("compacted into a snapshot\n");
+
+    char *path = malloc(strlen(directory) + 16);
+    sprintf(path, "%s/log.1", directory);
+    FILE *log = fopen(path, "a");
+    fputs("telex\t5", log);
+    fclose(log);
+
+    root = initTrie();
+    store = openStore(directory, root, NULL, 2);
+    string *query = initString("te", 2);
+    char **buffer = predictN(root, query, 4);
+    assert(strcmp(buffer[0], "tea") == 0);
+    assert(strcmp(buffer[1], "teleport") == 0);
+    assert(strcmp(buffer[2], "telephone") == 0);
+    assert(buffer[3] == NULL);
+    printf("recovered the snapshot and the log, and dropped the torn write\n");
+    for (int i = 0; i < 4; i++) {
+        free(buffer[i]);
+    }
+    free(buffer);
+    delString(query);
+    assert(store->logBytes == strlen("tea\t1\n"));
+    closeStore(store);
+    delTrie(root);
+
+    root = initTrie();
+    TrieBudget *budget = initTrieBudget(root, 12 * sizeof(Node));
+    store = openStore(directory, root, budget, 2);
+    assert(store != NULL && budget->evictedCount > 0 && budgetMemory(budget) <= budget->limit);
+    assert(root->children['t' - 'a']->children['e' - 'a']->children['a' - 'a']->weight == 1);
+    printf("recovered within a memory budget\n");
+    closeStore(store);
+    delTrieBudget(budget);
+    delTrie(root);
+
+    sprintf(path, "%s/snapshot", directory);
+    unlink(path);
+    sprintf(path, "%s/log.1", directory);
+    unlink(path);
+    rmdir(directory);
+    free(path);
+}
@@ -0,0 +1,341 @@
+/**
+ * @file suffix.c
+ * @author Arjun Pathak
+ * @brief This file contains the suffix array implementation for infix matching.
+ *
+ * This file contains the implementations of the functions declared in the suffix.h header file.
+ * The index is built in three steps: the words are collected out of the Trie with a DFS, every
+ * suffix of every word is recorded as an offset into one shared text buffer, and the offsets are
+ * sorted with a three way radix quicksort. Since each word is '\0' terminated, comparisons never
+ * run past the end of the word a suffix belongs to, so the sort stays cheap even for millions of
+ * words.
+ */
+
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "suffix.h"
+
+/**
+ * @brief A helper function that appends a word to the text buffer of the index.
+ *
+ * The text buffer and the word starts array are grown to double their size whenever they run out
+ * of room, the same way the custom string type grows.
+ *
+ * @param[in, out] index The index being built.
+ * @param[in] word The word to be copied into the index.
+ * @param[in, out] textCapacity The current capacity of the text buffer.
+ * @param[in, out] wordsCapacity The current capacity of the word starts array.
+ */
+
+static void addWord(SuffixIndex *index, string *word, int *textCapacity, int *wordsCapacity) {
+    while (index->textLength + word->length + 1 > *textCapacity) {
+        *textCapacity *= 2;
+        index->text = realloc(index->text, *textCapacity);
+    }
+    if (index->wordsCount == *wordsCapacity) {
+        *wordsCapacity *= 2;
+        index->wordStarts = realloc(index->wordStarts, *wordsCapacity * sizeof(int));
+    }
+    index->wordStarts[index->wordsCount++] = index->textLength;
+    memcpy(index->text + index->textLength, word->array, word->length + 1);
+    index->textLength += word->length + 1;
+}
+
+/**
+ * @brief A helper function that collects all the words of the Trie in alphabetical order.
+ *
+ * This function does a DFS on the Trie. The path from the root to the current node is kept in a
+ * single string which is appended to on the way down and truncated on the way back up.
+ *
+ * @param[in] current The Trie Node being visited.
+ * @param[in, out] path The letters on the path from the root to current.
+ * @param[in, out] index The index being built.
+ * @param[in, out] textCapacity The current capacity of the text buffer.
+ * @param[in, out] wordsCapacity The current capacity of the word starts array.
+ */
+
+static void collect(Node *current, string *path, SuffixIndex *index, int *textCapacity,
+                    int *wordsCapacity) {
+    if (current->isEndOfWord && path->length > 0) {
+        addWord(index, path, textCapacity, wordsCapacity);
+    }
+    for (int i = 0; i < 26; i++) {
+        if (current->children[i]) {
+            append(path, 'a' + i);
+            collect(current->children[i], path, index, textCapacity, wordsCapacity);
+            path->array[--path->length] = '\0';
+        }
+    }
+}
+
+static void swapSuffixes(int *suffixes, int i, int j) {
+    int temp = suffixes[i];
+    suffixes[i] = suffixes[j];
+    suffixes[j] = temp;
+}
+
+static int compareOffsets(const void *a, const void *b) {
+    return *(const int *)a - *(const int *)b;
+}
+
+/**
+ * @brief Sorts suffix offsets with a three way radix quicksort.
+ *
+ * The offsets are partitioned on the character at the given depth into smaller, equal and greater
+ * groups. The smaller and greater groups are sorted on the same depth, while the equal group moves
+ * on to the next character. Once the equal character is the '\0' terminator the suffixes in the
+ * group are identical, so they are ordered by offset, which keeps the words that share a suffix
+ * in alphabetical order.
+ *
+ * @param[in] text The text buffer the offsets point into.
+ * @param[in, out] suffixes The offsets to be sorted.
+ * @param[in] n The number of offsets.
+ * @param[in] depth The number of leading characters that are already known to be equal.
+ */
+
+static void sortSuffixes(const char *text, int *suffixes, int n, int depth) {
+    while (n > 1) {
+        if (n < 16) {
+            for (int i = 1; i < n; i++) {
+                for (int j = i; j > 0; j--) {
+                    int cmp = strcmp(text + suffixes[j - 1] + depth, text + suffixes[j] + depth);
+                    if (cmp < 0 || (cmp == 0 && suffixes[j - 1] < suffixes[j])) {
+                        break;
+                    }
+                    swapSuffixes(suffixes, j - 1, j);
+                }
+            }
+            return;
+        }
+
+        swapSuffixes(suffixes, 0, n / 2);
+        unsigned char pivot = text[suffixes[0] + depth];
+        int lt = 0, gt = n - 1, i = 0;
+        while (i <= gt) {
+            unsigned char c = text[suffixes[i] + depth];
+            if (c < pivot) {
+                swapSuffixes(suffixes, lt++, i++);
+            } else if (c > pivot) {
+                swapSuffixes(suffixes, i, gt--);
+            } else {
+                i++;
+            }
+        }
+
+        sortSuffixes(text, suffixes, lt, depth);
+        sortSuffixes(text, suffixes + gt + 1, n - gt - 1, depth);
+        if (pivot == '\0') {
+            qsort(suffixes + lt, gt - lt + 1, sizeof(int), compareOffsets);
+            return;
+        }
+        suffixes += lt;
+        n = gt - lt + 1;
+        depth++;
+    }
+}
+
+/**
+ * @brief Builds a substring index out of all the words stored in the Trie.
+ *
+ * The words are collected with collect(), after which the offset of every non empty suffix is
+ * recorded and the offsets are sorted with sortSuffixes().
+ *
+ * @param[in] root The root of a populated Trie.
+ *
+ * @return The newly built index.
+ */
+
+SuffixIndex *initSuffixIndex(Node *root) {
+    SuffixIndex *index = malloc(sizeof(SuffixIndex));
+    int textCapacity = 1024, wordsCapacity = 128;
+    index->text = malloc(textCapacity);
+    index->textLength = 0;
+    index->wordStarts = malloc(wordsCapacity * sizeof(int));
+    index->wordsCount = 0;
+
+    string *path = initString("", 0);
+    collect(root, path, index, &textCapacity, &wordsCapacity);
+    delString(path);
+
+    index->suffixesCount = index->textLength - index->wordsCount;
+    index->suffixes = malloc(sizeof(int) * (index->suffixesCount + 1));
+    int count = 0;
+    for (int i = 0; i < index->textLength; i++) {
+        if (index->text[i] != '\0') {
+            index->suffixes[count++] = i;
+        }
+    }
+    sortSuffixes(index->text, index->suffixes, count, 0);
+
+    return index;
+}
+
+/**
+ * @brief A helper function that maps an offset in the text buffer back to its word id.
+ *
+ * @param[in] index The index the offset belongs to.
+ * @param[in] offset The offset of a suffix.
+ *
+ * @return The id of the word that contains the offset.
+ */
+
+static int wordOf(SuffixIndex *index, int offset) {
+    int low = 0, high = index->wordsCount - 1;
+    while (low < high) {
+        int mid = low + (high - low + 1) / 2;
+        if (index->wordStarts[mid] <= offset) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief A helper function that binary searches the suffix array.
+ *
+ * @param[in] index The index to be searched.
+ * @param[in] word The sanitized query.
+ * @param[in] inclusive If true, the first suffix that does not start with the query and is
+ * greater than it is found. Otherwise the first suffix that is greater than or equal to it.
+ *
+ * @return The position in the suffixes array.
+ */
+
+static int bound(SuffixIndex *index, string *word, bool inclusive) {
+    int low = 0, high = index->suffixesCount;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        int cmp = strncmp(index->text + index->suffixes[mid], word->array, word->length);
+        if (cmp < 0 || (inclusive && cmp == 0)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief Returns the first N dictionary words that contain the given word anywhere inside them.
+ *
+ * The range of suffixes that start with the query is found with two binary searches. The range is
+ * then scanned in order and each suffix is mapped back to its word, skipping words that were
+ * already returned because they contain the query more than once. The scan stops as soon as N
+ * distinct words have been found, so broad queries cost no more than narrow ones.
+ *
+ * @param[in] index The index to be searched.
+ * @param[in] word The infix to be matched.
+ * @param[in] results The maximum number of results to be returned.
+ *
+ * @return A buffer of results entries, unused entries are set to NULL.
+ */
+
+char **searchN(SuffixIndex *index, string *word, int results) {
+    sanitize(word);
+    char **resultsBuffer = calloc(results, sizeof(char *));
+    int *ids = malloc(sizeof(int) * results);
+
+    int first = bound(index, word, false);
+    int last = bound(index, word, true);
+
+    int matches = 0;
+    for (int i = first; i < last && matches != results; i++) {
+        int id = wordOf(index, index->suffixes[i]);
+        bool seen = false;
+        for (int j = 0; j < matches; j++) {
+            if (ids[j] == id) {
+                seen = true;
+                break;
+            }
+        }
+        if (seen) {
+            continue;
+        }
+        const char *match = index->text + index->wordStarts[id];
+        resultsBuffer[matches] = malloc(strlen(match) + 1);
+        strcpy(resultsBuffer[matches], match);
+        ids[matches++] = id;
+    }
+
+    free(ids);
+    return resultsBuffer;
+}
+
+/**
+ * @brief Returns the number of heap bytes that are held by the index.
+ *
+ * @param[in] index The index that is to be measured.
+ */
+
+size_t suffixIndexMemory(SuffixIndex *index) {
+    return sizeof(SuffixIndex)
+        + index->textLength
+        + sizeof(int) * index->suffixesCount
+        + sizeof(int) * index->wordsCount;
+}
+
+/**
+ * @brief Reclaims all the memory held by the index.
+ *
+ * @param[in] index The index to be deleted.
+ */
+
+void delSuffixIndex(SuffixIndex *index) {
+    free(index->text);
+    free(index->suffixes);
+    free(index->wordStarts);
+    free(index);
+}
+
+/**
+ * @brief A function to test the suffix index and all supported operations on it.
+ */
+
+void testSuffixIndex() {
+    char *words[4] = {
+        "teleport",
+        "telephone",
+        "phone",
+        "megaphone",
+    };
+    Node *root = initTrie();
+    for (int i = 0; i < 4; i++) {
+        insert(root, words[i]);
+    }
+
+    SuffixIndex *index = initSuffixIndex(root);
+    assert(index->wordsCount == 4);
+    printf("built the suffix index\n");
+
+    string *query = initString("phone", 5);
+    char **buffer = searchN(index, query, 5);
+    assert(strcmp(buffer[0], "megaphone") == 0);
+    assert(strcmp(buffer[1], "phone") == 0);
+    assert(strcmp(buffer[2], "telephone") == 0);
+    assert(buffer[3] == NULL);
+    printf("infix search successful\n");
+    for (int i = 0; i < 5; i++) {
+        free(buffer[i]);
+    }
+    free(buffer);
+    delString(query);
+
+    query = initString("e", 1);
+    buffer = searchN(index, query, 5);
+    assert(buffer[3] != NULL && buffer[4] == NULL);
+    printf("repeated matches in the same word are returned once\n");
+    for (int i = 0; i < 5; i++) {
+        free(buffer[i]);
+    }
+    free(buffer);
+    delString(query);
+
+    delSuffixIndex(index);
+    delTrie(root);
+}
@@ -17,7 +17,10 @@
 #include <stdlib.h>
 
 #include "trie.h"
-#include "queue.h"
+
+#ifndef CANCEL_INTERVAL
+#define CANCEL_INTERVAL 64
+#endif
 
 /**
  * @brief This function is used to create a new trie node.
@@ -32,6 +35,9 @@
 static Node* createNode() {
     Node *newNode = (Node *)malloc(sizeof(Node));  
     newNode->isEndOfWord = false;
+    newNode->weight = 0;
+    newNode->maxWeight = 0;
+    newNode->id = -1;
     for (int i = 0; i < 26; i++) {
         newNode->children[i] = NULL;
     }
@@ -74,29 +80,66 @@ void delTrie(Node *node) {
 /**
  * @brief Used to insert a new word into the Trie.
  *
+ * This function is a wrapper around insertWeighted(), every insert counts as one occurrence of
+ * the word.
+ *
+ * @param[in] root The root of the Trie.
+ * @param[in] word The word to be inserted in the Trie.
+ * 
+ * @pre word is '\0' terminated.
+ */
+
+void insert(Node *root, const char* word) {
+    insertWeighted(root, word, 1);
+}
+
+/**
+ * @brief Used to insert a new word into the Trie with a weight.
+ *
  * This function is used to insert a new word into the Trie. It startes by
  * creating a pointer to the root of the tree (passed in as a parameter) and
  * traverses it down the trie, setting NULL pointers in the path to a new Trie
- * Node.
+ * Node. Uppercase letters are stored as their lowercase counterparts, and the
+ * word ends at its first character that is not a letter. The weight is added
+ * to the weight of the last Node.
  *
  * @param[in] root The root of the Trie.
  * @param[in] word The word to be inserted in the Trie.
+ * @param[in] weight The weight to be added to the word.
  * 
  * @pre word is '\0' terminated.
+ *
+ * @return The number of Nodes that were created for the word.
  */
 
-void insert(Node *root, const char* word) {
+int insertWeighted(Node *root, const char* word, unsigned int weight) {
     const char *temp = word;
     Node *current = root;
-    while (temp && *temp >= 'a' && *temp <= 'z') {
-        int idx = *temp - 'a';
+    int created = 0;
+    while (temp && ((*temp >= 'a' && *temp <= 'z') || (*temp >= 'A' && *temp <= 'Z'))) {
+        int idx = *temp >= 'a' ? *temp - 'a' : *temp - 'A';
         if (!current->children[idx]) {
             current->children[idx] = createNode();
+            created++;
         }
         current = current->children[idx];
         temp++;
     }
     current->isEndOfWord = true;
+    current->weight += weight;
+
+    unsigned int total = current->weight;
+    current = root;
+    for (temp = word; ; temp++) {
+        if (current->maxWeight < total) {
+            current->maxWeight = total;
+        }
+        if (!temp || !((*temp >= 'a' && *temp <= 'z') || (*temp >= 'A' && *temp <= 'Z'))) {
+            break;
+        }
+        current = current->children[*temp >= 'a' ? *temp - 'a' : *temp - 'A'];
+    }
+    return created;
 }
 
 /**
@@ -166,26 +209,37 @@ void predict(Node *root, string *word) {
     delString(prefix);
 }
 
-/** @brief This functions returns the first N number of predictions from the Trie
- *
- * This function performs a BFS on the Trie structure. It starts from the last matching node in the
- * trie with the word input and returns a list of prefix matches. The strings are C style null
- * terminated char arrays.
+/**
+ * @struct Step
+ * @brief An entry of the BFS frontier of an interleaved lookup.
  *
- * @param[in] root Root of the Trie Node.  @param[in] word The word to be prefix matched.
- * @param[in] results The number of results that the caller expects.  @param[out] resultsBuffer A
- * buffer to hold the words that successfully matched.
+ * @var Step::node
+ * Member node is the Trie Node to be visited.
+ * @var Step::parent
+ * Member parent is the position of the entry the node was reached from, or -1 for the Node the
+ * matched prefix ends at.
+ * @var Step::letter
+ * Member letter is the index of the letter on the edge from the parent to the node.
  */
 
-char **predictN(Node *root, string *word, int results) {
-    sanitize(word);
-    char **resultsBuffer = malloc(sizeof(char *) * results);
-    struct Entity {
-        Node *currTrieNode;
-        string *currPrefix;
-    };
-    typedef struct Entity Entity;
+struct Step {
+    Node *node;
+    int parent;
+    int letter;
+};
+typedef struct Step Step;
+
+/**
+ * @brief A helper function that walks down the Trie for as long as the word matches.
+ *
+ * @param[in] root The root of the Trie.
+ * @param[in] word The sanitized word.
+ * @param[out] matched The number of letters of the word that matched.
+ *
+ * @return The Node the matched prefix ends at.
+ */
 
+static Node *matchPrefix(Node *root, string *word, int *matched) {
     Node *itr = root;
     int count = 0;
     for (int i = 0; i < word->length; i++) {
@@ -197,55 +251,759 @@ char **predictN(Node *root, string *word, int results) {
             break;
         }
     }
-    string *prefix = duplicate(word);
-    prefix->array[count] = '\0';
-    prefix->length = count;
+    *matched = count;
+    return itr;
+}
+
+/**
+ * @brief A helper function that appends an entry to a frontier, growing it when it is full.
+ */
 
-    Entity *e = malloc(sizeof(Entity));
-    e->currTrieNode = itr;
-    e->currPrefix = prefix;
-    Queue *queue = initQueue(e);
+static void pushStep(Step **frontier, int *length, int *capacity, Step step) {
+    if (*length == *capacity) {
+        *capacity *= 2;
+        *frontier = realloc(*frontier, sizeof(Step) * *capacity);
+    }
+    (*frontier)[(*length)++] = step;
+}
 
-    int matches = 0;
-    while (queue->front && matches != results) {
-        Entity *frontValue = queue->front->value;
+/**
+ * @brief A helper function that runs a BFS below a Trie Node until N words are found.
+ *
+ * The frontier is a flat array instead of a queue of heap allocated entries. Entries are never
+ * removed, only passed by the head, so every entry can find the letters of its path through the
+ * parent positions of the entries before it, and no prefix has to be copied on the way down. The
+ * cancel flag is read every CANCEL_INTERVAL entries, which keeps the check out of the profile
+ * while still stopping a broad search well within a millisecond of being cancelled.
+ *
+ * @param[in] start The Node the matched prefix ends at.
+ * @param[in] resultsLength The number of words wanted.
+ * @param[in, out] frontier The frontier, grown as needed.
+ * @param[in, out] capacity The capacity of the frontier.
+ * @param[out] matches Receives the positions of the entries of the words that were found.
+ * @param[in] cancel A flag that stops the search once it is set, or NULL.
+ *
+ * @return The number of words that were found, or -1 if the search was cancelled.
+ */
 
-        if (frontValue->currTrieNode->isEndOfWord == true) {
-            char *match = calloc(frontValue->currPrefix->length + 1, 1);
-            strcpy(match, frontValue->currPrefix->array);
-            resultsBuffer[matches++] = match;
+static int searchFrontier(Node *start, int resultsLength, Step **frontier, int *capacity,
+                          int *matches, const atomic_bool *cancel) {
+    int length = 0, found = 0;
+    pushStep(frontier, &length, capacity, (Step){start, -1, 0});
+    for (int head = 0; head < length && found < resultsLength; head++) {
+        if (cancel && head % CANCEL_INTERVAL == 0
+            && atomic_load_explicit(cancel, memory_order_relaxed)) {
+            return -1;
+        }
+        Node *node = (*frontier)[head].node;
+        if (node->isEndOfWord) {
+            matches[found++] = head;
+            if (found == resultsLength) {
+                break;
+            }
         }
         for (int i = 0; i < 26; i++) {
-            if (frontValue->currTrieNode->children[i] != NULL) {
-                Entity *newEntity = malloc(sizeof(Entity));
-                newEntity->currTrieNode = frontValue->currTrieNode->children[i];
-                string *newPrefix = duplicate(frontValue->currPrefix);
-                append(newPrefix, i + 'a');
-                newEntity->currPrefix = newPrefix;
-                addToQueue(queue, newEntity);
+            if (node->children[i]) {
+                pushStep(frontier, &length, capacity, (Step){node->children[i], head, i});
             }
         }
+    }
+    return found;
+}
+
+/**
+ * @brief A helper function that copies out the word an entry of a frontier stands for.
+ *
+ * @param[in] frontier The frontier.
+ * @param[in] entry The position of the entry in the frontier.
+ * @param[in] prefix The letters of the matched prefix.
+ * @param[in] prefixLength The number of letters of the matched prefix.
+ */
 
-        delString(frontValue->currPrefix);
-        free(frontValue);
-        removeFromQueue(queue);
+static char *spellEntry(Step *frontier, int entry, const char *prefix, int prefixLength) {
+    int depth = 0;
+    for (int i = entry; frontier[i].parent != -1; i = frontier[i].parent) {
+        depth++;
     }
-    if (queue->front == NULL) {
-        deleteQueue(queue);
-        return resultsBuffer;
+    char *match = malloc(prefixLength + depth + 1);
+    memcpy(match, prefix, prefixLength);
+    match[prefixLength + depth] = '\0';
+    for (int i = entry; frontier[i].parent != -1; i = frontier[i].parent) {
+        match[prefixLength + --depth] = 'a' + frontier[i].letter;
+    }
+    return match;
+}
+
+/** @brief This functions returns the first N number of predictions from the Trie
+ *
+ * This function performs a BFS on the Trie structure. It starts from the last matching node in the
+ * trie with the word input and returns a list of prefix matches. The strings are C style null
+ * terminated char arrays.
+ *
+ * @param[in] root Root of the Trie Node.  @param[in] word The word to be prefix matched.
+ * @param[in] results The number of results that the caller expects.  @param[out] resultsBuffer A
+ * buffer to hold the words that successfully matched.
+ */
+
+char **predictN(Node *root, string *word, int results) {
+    sanitize(word);
+    char **resultsBuffer = calloc(results, sizeof(char *));
+    int count;
+    Node *itr = matchPrefix(root, word, &count);
+
+    int capacity = 64;
+    Step *frontier = malloc(sizeof(Step) * capacity);
+    int *matches = malloc(sizeof(int) * (results > 0 ? results : 1));
+    int found = searchFrontier(itr, results, &frontier, &capacity, matches, NULL);
+    for (int i = 0; i < found; i++) {
+        resultsBuffer[i] = spellEntry(frontier, matches[i], word->array, count);
+    }
+    free(matches);
+    free(frontier);
+
+    return resultsBuffer;
+}
+
+/**
+ * @struct Completion
+ * @brief A BFS that is paused between two matching words.
+ *
+ * @var Completion::frontier
+ * Member frontier is the BFS frontier, the same flat array predictN() uses.
+ * @var Completion::head
+ * Member head is the position of the next entry to be visited.
+ * @var Completion::prefix
+ * Member prefix holds the letters of the matched prefix, which every word starts with.
+ */
+
+struct Completion {
+    Step *frontier;
+    int length;
+    int capacity;
+    int head;
+    char *prefix;
+    int prefixLength;
+};
+
+/**
+ * @brief This function starts a search that returns the matching words one at a time, in the
+ * order of predictN().
+ *
+ * @param[in] root Root node of the Trie.
+ * @param[in] word Word to be prefix matched. It is sanitized in place.
+ *
+ * @return The newly created search.
+ */
+
+Completion *initCompletion(Node *root, string *word) {
+    sanitize(word);
+    Completion *completion = malloc(sizeof(Completion));
+    int count;
+    Node *itr = matchPrefix(root, word, &count);
+    completion->prefix = malloc(count + 1);
+    memcpy(completion->prefix, word->array, count);
+    completion->prefix[count] = '\0';
+    completion->prefixLength = count;
+    completion->capacity = 64;
+    completion->frontier = malloc(sizeof(Step) * completion->capacity);
+    completion->length = 0;
+    completion->head = 0;
+    pushStep(&completion->frontier, &completion->length, &completion->capacity,
+             (Step){itr, -1, 0});
+    return completion;
+}
+
+/**
+ * @brief This function resumes the search until it reaches the next matching word.
+ *
+ * @param[in] completion The search.
+ *
+ * @return The next matching word, which the caller frees, or NULL once there are no more.
+ */
+
+char *nextCompletion(Completion *completion) {
+    while (completion->head < completion->length) {
+        int head = completion->head++;
+        Node *node = completion->frontier[head].node;
+        for (int i = 0; i < 26; i++) {
+            if (node->children[i]) {
+                pushStep(&completion->frontier, &completion->length, &completion->capacity,
+                         (Step){node->children[i], head, i});
+            }
+        }
+        if (node->isEndOfWord) {
+            return spellEntry(completion->frontier, head, completion->prefix,
+                              completion->prefixLength);
+        }
     }
-    QueueNode *temp = queue->front;
-    while (temp != NULL) {
-        Entity *frontValue = temp->value;
-        delString(frontValue->currPrefix);
-        free(frontValue);
-        temp = temp->next;
+    return NULL;
+}
+
+/**
+ * @brief This function reclaims the memory held by a search.
+ *
+ * @param[in] completion The search.
+ */
+
+void delCompletion(Completion *completion) {
+    free(completion->frontier);
+    free(completion->prefix);
+    free(completion);
+}
+
+/**
+ * @struct Frame
+ * @brief An entry of the explicit stack of a depth-first walk.
+ *
+ * @var Frame::node
+ * Member node is the Trie Node at this depth of the path.
+ * @var Frame::next
+ * Member next is the index of the next child of the Node to be walked into, so the letter on the
+ * path below the Node is the one just before it.
+ */
+
+struct Frame {
+    Node *node;
+    int next;
+};
+typedef struct Frame Frame;
+
+/**
+ * @brief This function returns the first N matching words in the order of predictN(), using
+ * iterative deepening instead of a BFS.
+ *
+ * Every round walks the subtree depth-first down to a depth limit, visiting the children in
+ * alphabetical order, and takes the words that end exactly at the limit. The limit grows by one
+ * per round until N words are found or no Node lies below it, so the words come out level by level
+ * and, within a level, in the same order as the BFS queues them. The walk keeps only the path from
+ * the matched prefix to the current Node, which also spells the words, so its memory is bounded
+ * by the length of the longest word instead of the width of the widest level. The price is that
+ * the upper levels are walked again in every round.
+ *
+ * @param[in] root Root node of the Trie.
+ * @param[in] word Word to be prefix matched. It is sanitized in place.
+ * @param[in] results The number of results to be returned.
+ *
+ * @return The first results words matched in the Trie, with NULL for the missing ones.
+ */
+
+char **predictDeepening(Node *root, string *word, int results) {
+    sanitize(word);
+    char **resultsBuffer = calloc(results, sizeof(char *));
+    int count;
+    Node *itr = matchPrefix(root, word, &count);
+
+    int capacity = 16;
+    Frame *path = malloc(sizeof(Frame) * capacity);
+    int found = 0;
+    bool deeper = true;
+    for (int limit = 0; deeper && found < results; limit++) {
+        if (limit == capacity) {
+            capacity *= 2;
+            path = realloc(path, sizeof(Frame) * capacity);
+        }
+        deeper = false;
+        int depth = 0;
+        path[0] = (Frame){itr, 0};
+        while (depth >= 0 && found < results) {
+            Frame *frame = &path[depth];
+            if (depth == limit) {
+                if (frame->node->isEndOfWord) {
+                    char *match = malloc(count + limit + 1);
+                    memcpy(match, word->array, count);
+                    for (int i = 0; i < limit; i++) {
+                        match[count + i] = 'a' + path[i].next - 1;
+                    }
+                    match[count + limit] = '\0';
+                    resultsBuffer[found++] = match;
+                }
+                for (int i = 0; i < 26 && !deeper; i++) {
+                    deeper = frame->node->children[i] != NULL;
+                }
+                depth--;
+                continue;
+            }
+            while (frame->next < 26 && frame->node->children[frame->next] == NULL) {
+                frame->next++;
+            }
+            if (frame->next == 26) {
+                depth--;
+                continue;
+            }
+            path[depth + 1] = (Frame){frame->node->children[frame->next++], 0};
+            depth++;
+        }
     }
-    deleteQueue(queue);
+    free(path);
 
     return resultsBuffer;
 }
 
+/**
+ * @brief This function returns the Nodes of the first N matching words, without spelling them.
+ *
+ * The Nodes are found by the same BFS as predictN() and in the same order, so a caller that keeps
+ * something of its own on the Nodes, like the id of the word, can answer the query without
+ * building any strings.
+ *
+ * @param[in] root Root node of the Trie.
+ * @param[in] word Word to be prefix matched. It is sanitized in place.
+ * @param[in] resultsLength The number of results to be returned.
+ * @param[out] results Receives the Nodes, it must have room for resultsLength of them.
+ *
+ * @return The number of Nodes that were found.
+ */
+
+int predictNodes(Node *root, string *word, int resultsLength, Node **results) {
+    return predictNodesCancellable(root, word, resultsLength, results, NULL);
+}
+
+/**
+ * @brief This function returns the Nodes of the first N matching words, unless it is cancelled
+ * first.
+ *
+ * @param[in] root Root node of the Trie.
+ * @param[in] word Word to be prefix matched. It is sanitized in place.
+ * @param[in] resultsLength The number of results to be returned.
+ * @param[out] results Receives the Nodes, it must have room for resultsLength of them.
+ * @param[in] cancel A flag that another thread sets to stop the search, or NULL.
+ *
+ * @return The number of Nodes that were found, or -1 if the search was cancelled.
+ */
+
+int predictNodesCancellable(Node *root, string *word, int resultsLength, Node **results,
+                            const atomic_bool *cancel) {
+    sanitize(word);
+    int count;
+    Node *itr = matchPrefix(root, word, &count);
+
+    int capacity = 64;
+    Step *frontier = malloc(sizeof(Step) * capacity);
+    int *matches = malloc(sizeof(int) * (resultsLength > 0 ? resultsLength : 1));
+    int found = searchFrontier(itr, resultsLength, &frontier, &capacity, matches, cancel);
+    for (int i = 0; i < found; i++) {
+        results[i] = frontier[matches[i]].node;
+    }
+    free(matches);
+    free(frontier);
+    return found;
+}
+
+/**
+ * @struct Ranked
+ * @brief A word found by the ranked search.
+ *
+ * @var Ranked::node
+ * Member node is the Node the word ends at, which holds its weight.
+ * @var Ranked::depth
+ * Member depth is the number of letters of the word below the matched prefix.
+ * @var Ranked::order
+ * Member order is the position of the Node in the pre-order walk. Among words of the same length
+ * it is their alphabetical order.
+ * @var Ranked::word
+ * Member word is the word itself, if the search spells its words out, or NULL.
+ */
+
+struct Ranked {
+    Node *node;
+    int depth;
+    long order;
+    char *word;
+};
+typedef struct Ranked Ranked;
+
+/**
+ * @struct RankedSearch
+ * @brief The state of a ranked search.
+ *
+ * @var RankedSearch::heap
+ * Member heap holds the best words found so far, with the lowest ranked of them at the top.
+ * @var RankedSearch::length
+ * Member length is the number of words in the heap.
+ * @var RankedSearch::capacity
+ * Member capacity is the number of words wanted.
+ * @var RankedSearch::visited
+ * Member visited is the number of Nodes visited so far.
+ * @var RankedSearch::path
+ * Member path holds the letters down to the Node being visited, or is NULL if the words are not
+ * spelled out.
+ */
+
+struct RankedSearch {
+    Ranked *heap;
+    int length;
+    int capacity;
+    long visited;
+    string *path;
+    const atomic_bool *cancel;
+    bool cancelled;
+};
+typedef struct RankedSearch RankedSearch;
+
+/**
+ * @brief A helper function that tells whether a word ranks below another one, which is the case
+ * if it has a lower weight, or the same weight and comes after it in the order of predictN().
+ */
+
+static bool ranksBelow(Ranked *a, Ranked *b) {
+    if (a->node->weight != b->node->weight) {
+        return a->node->weight < b->node->weight;
+    }
+    if (a->depth != b->depth) {
+        return a->depth > b->depth;
+    }
+    return a->order > b->order;
+}
+
+/**
+ * @brief A helper function that moves a word down the heap until no word below it ranks lower.
+ */
+
+static void siftDown(Ranked *heap, int length, int index) {
+    while (true) {
+        int lowest = index;
+        for (int child = 2 * index + 1; child <= 2 * index + 2 && child < length; child++) {
+            if (ranksBelow(&heap[child], &heap[lowest])) {
+                lowest = child;
+            }
+        }
+        if (lowest == index) {
+            return;
+        }
+        Ranked swap = heap[index];
+        heap[index] = heap[lowest];
+        heap[lowest] = swap;
+        index = lowest;
+    }
+}
+
+/**
+ * @brief A helper function that keeps a word if fewer words than wanted were found so far, or if
+ * it ranks above the lowest ranked word kept, which it then replaces.
+ */
+
+static void offerRanked(RankedSearch *search, Ranked ranked) {
+    bool full = search->length == search->capacity;
+    if (full && !ranksBelow(&search->heap[0], &ranked)) {
+        return;
+    }
+    if (search->path) {
+        ranked.word = malloc(search->path->length + 1);
+        memcpy(ranked.word, search->path->array, search->path->length + 1);
+    }
+    if (full) {
+        free(search->heap[0].word);
+        search->heap[0] = ranked;
+        siftDown(search->heap, search->length, 0);
+        return;
+    }
+
+    int index = search->length++;
+    search->heap[index] = ranked;
+    while (index > 0 && ranksBelow(&search->heap[index], &search->heap[(index - 1) / 2])) {
+        Ranked swap = search->heap[index];
+        search->heap[index] = search->heap[(index - 1) / 2];
+        search->heap[(index - 1) / 2] = swap;
+        index = (index - 1) / 2;
+    }
+}
+
+/**
+ * @brief A helper function that offers every word below a Node to the heap, in pre-order.
+ *
+ * Once the heap is full, a child whose maxWeight is below the lowest weight in the heap holds no
+ * word that could make it in, so its whole subtree is skipped. The cancel flag is read every
+ * CANCEL_INTERVAL Nodes, the same way the BFS reads it.
+ *
+ * @param[in, out] search The search.
+ * @param[in] node The Trie Node being visited.
+ * @param[in] depth The depth of the Node below the matched prefix.
+ */
+
+static void rankBelow(RankedSearch *search, Node *node, int depth) {
+    long order = search->visited++;
+    if (search->cancel && order % CANCEL_INTERVAL == 0
+        && atomic_load_explicit(search->cancel, memory_order_relaxed)) {
+        search->cancelled = true;
+    }
+    if (search->cancelled) {
+        return;
+    }
+    if (node->isEndOfWord) {
+        offerRanked(search, (Ranked){node, depth, order, NULL});
+    }
+    for (int i = 0; i < 26; i++) {
+        if (node->children[i] == NULL
+            || (search->length == search->capacity
+                && node->children[i]->maxWeight < search->heap[0].node->weight)) {
+            continue;
+        }
+        if (search->path) {
+            append(search->path, 'a' + i);
+        }
+        rankBelow(search, node->children[i], depth + 1);
+        if (search->path) {
+            search->path->array[--search->path->length] = '\0';
+        }
+    }
+}
+
+/**
+ * @brief A helper function that finds the N highest weighted words below a Node and sorts them,
+ * the highest ranked first.
+ *
+ * @param[in] start The Node the matched prefix ends at.
+ * @param[in] resultsLength The number of words wanted, at least one.
+ * @param[in, out] path The letters of the matched prefix, to spell the words out, or NULL.
+ * @param[in] cancel A flag that stops the search once it is set, or NULL.
+ * @param[out] ranked Receives the words, it must have room for resultsLength of them.
+ *
+ * @return The number of words that were found, or -1 if the search was cancelled.
+ */
+
+static int searchRanked(Node *start, int resultsLength, string *path, const atomic_bool *cancel,
+                        Ranked *ranked) {
+    RankedSearch search = {
+        .heap = ranked,
+        .capacity = resultsLength,
+        .path = path,
+        .cancel = cancel,
+    };
+    rankBelow(&search, start, 0);
+    if (search.cancelled) {
+        for (int i = 0; i < search.length; i++) {
+            free(ranked[i].word);
+        }
+        return -1;
+    }
+    for (int length = search.length; length > 1; length--) {
+        Ranked swap = ranked[0];
+        ranked[0] = ranked[length - 1];
+        ranked[length - 1] = swap;
+        siftDown(ranked, length - 1, 0);
+    }
+    return search.length;
+}
+
+/**
+ * @brief This function returns the N matching words with the highest weights, spelled out.
+ *
+ * @param[in] root Root node of the Trie.
+ * @param[in] word Word to be prefix matched. It is sanitized in place.
+ * @param[in] resultsLength The number of results to be returned.
+ *
+ * @return The matched words, the highest ranked first, laid out the same way as the buffers
+ * returned by predictN().
+ */
+
+char **predictRanked(Node *root, string *word, int resultsLength) {
+    sanitize(word);
+    char **resultsBuffer = calloc(resultsLength, sizeof(char *));
+    if (resultsLength <= 0) {
+        return resultsBuffer;
+    }
+    int count;
+    Node *itr = matchPrefix(root, word, &count);
+
+    string *path = initString("", 0);
+    for (int i = 0; i < count; i++) {
+        append(path, word->array[i]);
+    }
+    Ranked *ranked = malloc(sizeof(Ranked) * resultsLength);
+    int found = searchRanked(itr, resultsLength, path, NULL, ranked);
+    for (int i = 0; i < found; i++) {
+        resultsBuffer[i] = ranked[i].word;
+    }
+    free(ranked);
+    delString(path);
+    return resultsBuffer;
+}
+
+/**
+ * @brief This function returns the Nodes of the N matching words with the highest weights, unless
+ * another thread cancels the search first.
+ *
+ * @param[in] root Root node of the Trie.
+ * @param[in] word Word to be prefix matched. It is sanitized in place.
+ * @param[in] resultsLength The number of results to be returned.
+ * @param[out] results Receives the Nodes, it must have room for resultsLength of them.
+ * @param[in] cancel A flag that another thread sets to stop the search, or NULL.
+ *
+ * @return The number of Nodes that were found, or -1 if the search was cancelled.
+ */
+
+int predictRankedNodes(Node *root, string *word, int resultsLength, Node **results,
+                       const atomic_bool *cancel) {
+    sanitize(word);
+    if (resultsLength <= 0) {
+        return 0;
+    }
+    int count;
+    Node *itr = matchPrefix(root, word, &count);
+
+    Ranked *ranked = malloc(sizeof(Ranked) * resultsLength);
+    int found = searchRanked(itr, resultsLength, NULL, cancel, ranked);
+    for (int i = 0; i < found; i++) {
+        results[i] = ranked[i].node;
+    }
+    free(ranked);
+    return found;
+}
+
+/**
+ * @struct Lookup
+ * @brief The state of one query of an interleaved group, kept between its turns.
+ */
+
+struct Lookup {
+    string *word;
+    char **results;
+    int matches;
+    int index;
+    bool walking;
+    int position;
+    Node *node;
+    Step *frontier;
+    int head;
+    int length;
+    int capacity;
+};
+typedef struct Lookup Lookup;
+
+#ifndef INTERLEAVE_GROUP
+#define INTERLEAVE_GROUP 16
+#endif
+
+/**
+ * @brief A helper function that asks for every cache line of a Trie Node to be loaded.
+ */
+
+static void prefetchNode(Node *node) {
+    for (size_t offset = 0; offset < sizeof(Node); offset += 64) {
+        __builtin_prefetch((char *)node + offset);
+    }
+}
+
+static void startLookup(Lookup *lookup, Node *root, string *word, int index, int resultsLength) {
+    sanitize(word);
+    lookup->word = word;
+    lookup->results = calloc(resultsLength, sizeof(char *));
+    lookup->matches = 0;
+    lookup->index = index;
+    lookup->walking = true;
+    lookup->position = 0;
+    lookup->node = root;
+    lookup->head = 0;
+    lookup->length = 0;
+}
+
+/**
+ * @brief A helper function that gives a lookup its turn, moving it forward by a single Node.
+ *
+ * While the lookup walks down its prefix, a turn follows one letter. Once the prefix stops
+ * matching, the Node it ended at seeds the frontier, and every later turn visits one entry of
+ * the frontier in the same order as the queue of predictN(). Either way the Node for the next
+ * turn is prefetched before the turn ends.
+ *
+ * @param[in, out] lookup The lookup.
+ * @param[in] resultsLength The number of results wanted.
+ *
+ * @return true once the lookup has all of its results.
+ */
+
+static bool advanceLookup(Lookup *lookup, int resultsLength) {
+    if (lookup->walking) {
+        if (lookup->position < lookup->word->length) {
+            Node *child = lookup->node->children[lookup->word->array[lookup->position] - 'a'];
+            if (child) {
+                lookup->node = child;
+                lookup->position++;
+                prefetchNode(child);
+                return false;
+            }
+        }
+        lookup->walking = false;
+        pushStep(&lookup->frontier, &lookup->length, &lookup->capacity,
+                 (Step){lookup->node, -1, 0});
+    }
+
+    if (lookup->matches == resultsLength) {
+        return true;
+    }
+    Node *node = lookup->frontier[lookup->head].node;
+    if (node->isEndOfWord) {
+        lookup->results[lookup->matches++] = spellEntry(lookup->frontier, lookup->head,
+                                                        lookup->word->array, lookup->position);
+        if (lookup->matches == resultsLength) {
+            return true;
+        }
+    }
+    for (int i = 0; i < 26; i++) {
+        if (node->children[i]) {
+            pushStep(&lookup->frontier, &lookup->length, &lookup->capacity,
+                     (Step){node->children[i], lookup->head, i});
+        }
+    }
+    if (++lookup->head == lookup->length) {
+        return true;
+    }
+    prefetchNode(lookup->frontier[lookup->head].node);
+    return false;
+}
+
+/**
+ * @brief This function answers many queries at once, with the same results as predictN().
+ *
+ * A group of lookups is advanced in round robin, one Node per turn each. This is asynchronous
+ * memory access chaining: by the time a lookup gets its next turn, the Node it prefetched at the
+ * end of its last turn has usually arrived in the cache, so a single core keeps several memory
+ * loads in flight instead of waiting for each one in turn. A finished lookup hands its slot to the
+ * next query right away, which keeps the group full until the queries run out.
+ *
+ * @param[in] root Root node of the Trie.
+ * @param[in] words The words to be prefix matched. Each one is sanitized in place.
+ * @param[in] wordsCount The number of words.
+ * @param[in] resultsLength The number of results to be returned per word.
+ * @param[out] results Receives one buffer of resultsLength entries per word.
+ */
+
+void predictNBatch(Node *root, string **words, int wordsCount, int resultsLength,
+                   char ***results) {
+    Lookup group[INTERLEAVE_GROUP];
+    int active = 0, next = 0;
+    for (int i = 0; i < INTERLEAVE_GROUP; i++) {
+        group[i].capacity = 64;
+        group[i].frontier = malloc(sizeof(Step) * group[i].capacity);
+        group[i].word = NULL;
+        if (next < wordsCount) {
+            startLookup(&group[i], root, words[next], next, resultsLength);
+            next++;
+            active++;
+        }
+    }
+
+    while (active > 0) {
+        for (int i = 0; i < INTERLEAVE_GROUP; i++) {
+            Lookup *lookup = &group[i];
+            if (lookup->word == NULL || !advanceLookup(lookup, resultsLength)) {
+                continue;
+            }
+            results[lookup->index] = lookup->results;
+            if (next < wordsCount) {
+                startLookup(lookup, root, words[next], next, resultsLength);
+                next++;
+            } else {
+                lookup->word = NULL;
+                active--;
+            }
+        }
+    }
+
+    for (int i = 0; i < INTERLEAVE_GROUP; i++) {
+        free(group[i].frontier);
+    }
+}
+
 /**
  * @brief A function to test the Trie Structure and all supported operations on it.
  */
@@ -287,5 +1045,106 @@ void testTrie() {
         free(buffer);
         delString(query);
     }
+
+    string *queries[5];
+    char **batch[5];
+    for (int i = 0; i < nTests; i++) {
+        queries[i] = initString(tests[i], strlen(tests[i]));
+    }
+    predictNBatch(root, queries, nTests, 2, batch);
+    for (int i = 0; i < nTests; i++) {
+        char **buffer = predictN(root, queries[i], 2);
+        for (int j = 0; j < 2; j++) {
+            assert((buffer[j] == NULL) == (batch[i][j] == NULL));
+            assert(buffer[j] == NULL || strcmp(buffer[j], batch[i][j]) == 0);
+            free(buffer[j]);
+            free(batch[i][j]);
+        }
+        free(buffer);
+        free(batch[i]);
+        delString(queries[i]);
+    }
+    printf("batched predictions match predictN\n");
+
+    for (int i = 0; i < nTests; i++) {
+        string *query = initString(tests[i], strlen(tests[i]));
+        string *copy = duplicate(query);
+        char **expected = predictN(root, query, 4);
+        char **buffer = predictDeepening(root, copy, 4);
+        for (int j = 0; j < 4; j++) {
+            assert((expected[j] == NULL) == (buffer[j] == NULL));
+            assert(buffer[j] == NULL || strcmp(expected[j], buffer[j]) == 0);
+            free(expected[j]);
+            free(buffer[j]);
+        }
+        free(expected);
+        free(buffer);
+        delString(query);
+        delString(copy);
+    }
+    printf("iterative deepening predictions match predictN\n");
+
+    string *prefix = initString("tele", 4);
+    Completion *completion = initCompletion(root, prefix);
+    char *next = nextCompletion(completion);
+    assert(strcmp(next, "telegram") == 0);
+    free(next);
+    next = nextCompletion(completion);
+    assert(strcmp(next, "teleport") == 0);
+    free(next);
+    next = nextCompletion(completion);
+    assert(strcmp(next, "telephone") == 0);
+    free(next);
+    assert(nextCompletion(completion) == NULL);
+    delCompletion(completion);
+    delString(prefix);
+    printf("resumable search returned the words one at a time\n");
+
+    atomic_bool cancel = false;
+    Node *nodes[2];
+    string *query = initString("tele", 4);
+    assert(predictNodesCancellable(root, query, 2, nodes, &cancel) == 2);
+    atomic_store(&cancel, true);
+    assert(predictNodesCancellable(root, query, 2, nodes, &cancel) == -1);
+    delString(query);
+    printf("cancelled search returned no results\n");
+
+    for (int i = 0; i < nTests; i++) {
+        string *query = initString(tests[i], strlen(tests[i]));
+        string *copy = duplicate(query);
+        char **expected = predictN(root, query, 4);
+        char **buffer = predictRanked(root, copy, 4);
+        for (int j = 0; j < 4; j++) {
+            assert((expected[j] == NULL) == (buffer[j] == NULL));
+            assert(expected[j] == NULL || strcmp(expected[j], buffer[j]) == 0);
+            free(expected[j]);
+            free(buffer[j]);
+        }
+        free(expected);
+        free(buffer);
+        delString(query);
+        delString(copy);
+    }
+    printf("ranked predictions match predictN when every weight is the same\n");
+
+    insertWeighted(root, "telephone", 5);
+    insertWeighted(root, "teleport", 1);
+    insertWeighted(root, "tea", 2);
+    char *ranked[4] = {"telephone", "tea", "teleport", "telegram"};
+    query = initString("t", 1);
+    char **buffer = predictRanked(root, query, 5);
+    for (int i = 0; i < 4; i++) {
+        assert(strcmp(buffer[i], ranked[i]) == 0);
+        free(buffer[i]);
+    }
+    assert(buffer[4] == NULL);
+    free(buffer);
+    atomic_store(&cancel, false);
+    assert(predictRankedNodes(root, query, 2, nodes, &cancel) == 2);
+    assert(nodes[0]->weight == 6 && nodes[1]->weight == 2);
+    atomic_store(&cancel, true);
+    assert(predictRankedNodes(root, query, 2, nodes, &cancel) == -1);
+    delString(query);
+    printf("ranked predictions put the highest weights first\n");
     delTrie(root);
 }
@@ -0,0 +1,297 @@
+/**
+ * @file tui.c
+ * @author Arjun Pathak
+ * @brief This file contains the implementation of the ncurses terminal interface.
+ *
+ * This file contains the implementations of the functions declared in the tui.h header file.
+ * The calling thread owns the terminal: it waits with poll() on both the keyboard and a pipe the
+ * worker writes to, so it wakes up for a key press or for a finished search, whichever comes
+ * first, and it is the only thread that calls into ncurses. A keystroke hands the new query to
+ * the worker and sets the cancel flag that predictNodesCancellable() checks inside its traversal
+ * loop, so the worker drops a stale search well within a millisecond and moves on to the newest
+ * query. Results are only published if no newer query was submitted while they were searched for.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <ncurses.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tui.h"
+
+#define QUERY_SIZE 64
+#define ESCAPE_KEY 27
+#define END_OF_INPUT_KEY 4
+#define ERASE_LINE_KEY 21
+#define DELETE_KEY 127
+#define ESCAPE_DELAY_MS 25
+
+/**
+ * @struct Worker
+ * @brief The state shared by the input thread and the worker thread.
+ *
+ * @var Worker::ranked
+ * Member ranked is set if the search returns the words with the highest weights.
+ * @var Worker::cancel
+ * Member cancel is set by the input thread to stop the search that is running.
+ * @var Worker::query
+ * Member query is the newest query, waiting to be picked up if pending is set.
+ * @var Worker::submitted
+ * Member submitted is the number of queries submitted so far, which doubles as the generation of
+ * the newest one.
+ * @var Worker::submittedAt
+ * Member submittedAt is the time in nanoseconds at which the newest query was submitted.
+ * @var Worker::views
+ * Member views holds the results of the newest query that was answered.
+ * @var Worker::answered
+ * Member answered is the generation of the query the views belong to.
+ * @var Worker::searchTime
+ * Member searchTime is the time in nanoseconds the search for the views took.
+ * @var Worker::dropped
+ * Member dropped is the number of searches that were cancelled or finished too late to be drawn.
+ * @var Worker::notify
+ * Member notify is the pipe the worker writes a byte to whenever new views are published.
+ */
+
+struct Worker {
+    Node *root;
+    WordPool *pool;
+    int resultsLength;
+    bool ranked;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    atomic_bool cancel;
+    char query[QUERY_SIZE];
+    unsigned long submitted;
+    double submittedAt;
+    bool pending;
+    bool stopping;
+    WordView *views;
+    int found;
+    unsigned long answered;
+    double searchTime;
+    unsigned long dropped;
+    int notify[2];
+};
+typedef struct Worker Worker;
+
+static double now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1e9 + time.tv_nsec;
+}
+
+/**
+ * @brief The worker thread, which searches for the newest query until it is told to stop.
+ *
+ * @param[in] arg The worker.
+ */
+
+static void *searchQueries(void *arg) {
+    Worker *worker = arg;
+    Node **nodes = malloc(sizeof(Node *) * worker->resultsLength);
+    pthread_mutex_lock(&worker->lock);
+    while (true) {
+        while (!worker->pending && !worker->stopping) {
+            pthread_cond_wait(&worker->wake, &worker->lock);
+        }
+        if (worker->stopping) {
+            break;
+        }
+        string *query = initString(worker->query, strlen(worker->query));
+        unsigned long generation = worker->submitted;
+        worker->pending = false;
+        atomic_store(&worker->cancel, false);
+        pthread_mutex_unlock(&worker->lock);
+
+        double start = now();
+        int found = worker->ranked
+            ? predictRankedNodes(worker->root, query, worker->resultsLength, nodes, &worker->cancel)
+            : predictNodesCancellable(worker->root, query, worker->resultsLength, nodes,
+                                      &worker->cancel);
+        double elapsed = now() - start;
+        delString(query);
+
+        pthread_mutex_lock(&worker->lock);
+        if (found == -1 || generation != worker->submitted) {
+            worker->dropped++;
+            continue;
+        }
+        for (int i = 0; i < found; i++) {
+            worker->views[i] = poolView(worker->pool, nodes[i]->id);
+        }
+        worker->found = found;
+        worker->answered = generation;
+        worker->searchTime = elapsed;
+        char byte = 0;
+        if (write(worker->notify[1], &byte, 1) == -1 && errno != EAGAIN) {
+            worker->stopping = true;
+        }
+    }
+    pthread_mutex_unlock(&worker->lock);
+    free(nodes);
+    return NULL;
+}
+
+/**
+ * @brief A helper function that hands a query to the worker, cancelling the search that is running.
+ */
+
+static void submitQuery(Worker *worker, const char *query) {
+    pthread_mutex_lock(&worker->lock);
+    strcpy(worker->query, query);
+    worker->submitted++;
+    worker->submittedAt = now();
+    worker->pending = true;
+    atomic_store(&worker->cancel, true);
+    pthread_cond_signal(&worker->wake);
+    pthread_mutex_unlock(&worker->lock);
+}
+
+/**
+ * @brief A helper function that redraws the whole screen.
+ *
+ * @param[in] query The query as it is typed so far.
+ * @param[in] views The results of the newest query that was answered.
+ * @param[in] found The number of results.
+ * @param[in] searchTime The time in nanoseconds the search took.
+ * @param[in] latency The time in nanoseconds from the keystroke to the results being drawn.
+ * @param[in] dropped The number of searches that were dropped so far.
+ */
+
+static void drawScreen(const char *query, WordView *views, int found, double searchTime,
+                       double latency, unsigned long dropped) {
+    erase();
+    mvprintw(0, 0, "Type to search, Backspace to erase, Ctrl-U to clear, Esc to quit.");
+    for (int i = 0; i < found; i++) {
+        mvprintw(4 + i, 2, "%.*s", views[i].length, views[i].word);
+    }
+    mvprintw(5 + found, 0, "%d results, searched in %.1f us, drawn %.1f us after the keystroke",
+             found, searchTime / 1e3, latency / 1e3);
+    mvprintw(6 + found, 0, "%lu stale searches dropped", dropped);
+    mvprintw(2, 0, "> %s", query);
+    refresh();
+}
+
+/**
+ * @brief Runs the terminal interface until the user quits with Esc or Ctrl-D.
+ *
+ * @param[in] root The root of the Trie. It must not be changed while the interface runs.
+ * @param[in] pool The pool every word of the Trie is interned in.
+ * @param[in] resultsLength The number of results shown per query.
+ * @param[in] ranked Whether the words with the highest weights are shown instead of the first
+ * ones in the order of predictN().
+ *
+ * @return The number of queries whose results were drawn, or -1 if the terminal could not be
+ * set up.
+ */
+
+long runTui(Node *root, WordPool *pool, int resultsLength, bool ranked) {
+    Worker worker = {0};
+    if (pipe(worker.notify) == -1) {
+        return -1;
+    }
+    SCREEN *screen = newterm(NULL, stdout, stdin);
+    if (screen == NULL) {
+        close(worker.notify[0]);
+        close(worker.notify[1]);
+        return -1;
+    }
+    cbreak();
+    noecho();
+    keypad(stdscr, TRUE);
+    nodelay(stdscr, TRUE);
+    set_escdelay(ESCAPE_DELAY_MS);
+
+    fcntl(worker.notify[0], F_SETFL, O_NONBLOCK);
+    fcntl(worker.notify[1], F_SETFL, O_NONBLOCK);
+    worker.root = root;
+    worker.pool = pool;
+    worker.resultsLength = resultsLength;
+    worker.ranked = ranked;
+    worker.views = malloc(sizeof(WordView) * resultsLength);
+    atomic_init(&worker.cancel, false);
+    pthread_mutex_init(&worker.lock, NULL);
+    pthread_cond_init(&worker.wake, NULL);
+    pthread_t thread;
+    pthread_create(&thread, NULL, searchQueries, &worker);
+
+    char query[QUERY_SIZE] = "";
+    int length = 0;
+    WordView *views = malloc(sizeof(WordView) * resultsLength);
+    int found = 0;
+    double searchTime = 0, latency = 0;
+    unsigned long dropped = 0;
+    long drawn = 0;
+    submitQuery(&worker, query);
+    drawScreen(query, views, found, searchTime, latency, dropped);
+
+    struct pollfd sources[2] = {{STDIN_FILENO, POLLIN, 0}, {worker.notify[0], POLLIN, 0}};
+    bool running = true;
+    while (running) {
+        if (poll(sources, 2, -1) == -1 && errno != EINTR) {
+            break;
+        }
+
+        bool changed = false;
+        int key;
+        while (running && (key = getch()) != ERR) {
+            if (key == ESCAPE_KEY || key == END_OF_INPUT_KEY) {
+                running = false;
+            } else if ((key == KEY_BACKSPACE || key == DELETE_KEY || key == '\b') && length > 0) {
+                query[--length] = '\0';
+                changed = true;
+            } else if (key == ERASE_LINE_KEY && length > 0) {
+                query[length = 0] = '\0';
+                changed = true;
+            } else if (((key >= 'a' && key <= 'z') || (key >= 'A' && key <= 'Z'))
+                       && length < QUERY_SIZE - 1) {
+                query[length++] = key;
+                query[length] = '\0';
+                changed = true;
+            }
+        }
+        if (changed) {
+            submitQuery(&worker, query);
+        }
+
+        char bytes[64];
+        if (read(worker.notify[0], bytes, sizeof(bytes)) > 0) {
+            pthread_mutex_lock(&worker.lock);
+            if (worker.answered == worker.submitted) {
+                memcpy(views, worker.views, sizeof(WordView) * worker.found);
+                found = worker.found;
+                searchTime = worker.searchTime;
+                latency = now() - worker.submittedAt;
+                drawn++;
+            }
+            dropped = worker.dropped;
+            pthread_mutex_unlock(&worker.lock);
+        }
+        drawScreen(query, views, found, searchTime, latency, dropped);
+    }
+
+    pthread_mutex_lock(&worker.lock);
+    worker.stopping = true;
+    atomic_store(&worker.cancel, true);
+    pthread_cond_signal(&worker.wake);
+    pthread_mutex_unlock(&worker.lock);
+    pthread_join(thread, NULL);
+
+    endwin();
+    delscreen(screen);
+    close(worker.notify[0]);
+    close(worker.notify[1]);
+    pthread_mutex_destroy(&worker.lock);
+    pthread_cond_destroy(&worker.wake);
+    free(worker.views);
+    free(views);
+    return drawn;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file test.c
+ * @author Arjun Pathak
+ * @brief Runs the test function of every module.
+ *
+ * Every module keeps its test next to its implementation, as a testX() function that asserts on
+ * the behaviour of the module and prints a line for every check that passed. This program runs
+ * all of them in order, so a failing assert stops the run at the module that broke.
+ */
+
+#include <stdio.h>
+
+#include "budget.h"
+#include "cache.h"
+#include "darray.h"
+#include "engine.h"
+#include "ingest.h"
+#include "louds.h"
+#include "ngram.h"
+#include "pool.h"
+#include "queue.h"
+#include "shards.h"
+#include "store.h"
+#include "suffix.h"
+#include "trie.h"
+
+int main() {
+    testQueue();
+    testTrie();
+    testWordPool();
+    testSuffixIndex();
+    testShards();
+    testLouds();
+    testDoubleArray();
+    testResultCache();
+    testStore();
+    testNGramModel();
+    testEngines();
+    testTrieBudget();
+    testIngest();
+    printf("\nAll tests passed.\n");
+    return 0;
+}